@@ -70,6 +70,8 @@ void adsrGuiComponent::sliderValueChanged(juce::Slider* slider)
     {
         if (slider == sliders[i]) { parameters[i] = (float)slider->getValue(); }
     }
+
+    synthAudioSource.amplitudeEnvelope(getAttack(), getDecay(), getSustain(), getRelease());
 }
 
 float adsrGuiComponent::getAttack()
@@ -0,0 +1,566 @@
+/*
+  ==============================================================================
+
+    BenchmarkMain.cpp
+
+    Microbenchmarks for the hot paths, see PulsarBench.jucer.
+
+    PulsarBench [--seconds 1] [--out results.json]
+                [--rates 44100,48000,96000] [--blocks 64,256,1024]
+                [--formants 0.1,1] [--indices 0,1] [--voices 1,8,32] [--pulsarets 3,16]
+                [--oversampling 1,4] [--channels 2,16] [--panning 0,1]
+
+    Every combination is measured, results are written as JSON:
+    ns/sample, real time factor and for the voice benchmark the number of voices one core can run.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PulsarVoice.h"
+#include "RealtimeCheck.h"
+
+namespace
+{
+    /* keeps the optimiser from throwing the rendered samples away. */
+    volatile float sink = 0.0f;
+
+    /* renders that came out different with skipSilence on, see checkSkipSilence. */
+    int skipSilenceMismatches = 0;
+
+    struct BenchmarkSettings
+    {
+        double seconds = 1.0;
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        juce::Array<double> blockSizes  { 64.0, 256.0, 1024.0 };
+        juce::Array<double> formants    { 0.1, 1.0 };
+        juce::Array<double> indices     { 0.0, 1.0 };
+        juce::Array<double> voiceCounts { 1.0, 8.0, 32.0 };
+        juce::Array<double> pulsaretCounts { 3.0, 16.0 };
+        juce::Array<double> oversamplingFactors { 1.0, 4.0 };
+        juce::Array<double> channelCounts { 2.0 };
+        juce::Array<double> panningModes { 0.0 };
+    };
+
+    juce::Array<double> parseList(const juce::ArgumentList& args, const juce::String& option, const juce::Array<double>& defaults)
+    {
+        if (!args.containsOption(option))
+            return defaults;
+
+        juce::Array<double> values;
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption(option), ",", ""))
+            values.add(token.getDoubleValue());
+
+        return values;
+    }
+
+    void printUsage(const juce::String& executableName)
+    {
+        std::cerr << "usage: " << executableName << " [--seconds 1] [--out results.json]\n"
+                  << "    [--rates 44100,48000,96000] [--blocks 64,256,1024]\n"
+                  << "    [--formants 0.1,1] [--indices 0,1] [--voices 1,8,32] [--pulsarets 3,16]\n"
+                  << "    [--oversampling 1,4] [--channels 2,16] [--panning 0,1]" << std::endl;
+    }
+
+    double secondsSince(juce::int64 startTicks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    /* one JSON result, samples is the number of samples rendered (per voice, times voices). */
+    juce::var makeResult(const juce::String& name, double sampleRate, double seconds, double samples, double audioSeconds)
+    {
+        auto* result = new juce::DynamicObject();
+        result->setProperty("benchmark", name);
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("nsPerSample", seconds * 1.0e9 / samples);
+        result->setProperty("realTimeFactor", audioSeconds / seconds);
+        return juce::var(result);
+    }
+
+    const WavetableMipmap& getSine()
+    {
+        static juce::SharedResourcePointer<WavetableBank> bank;
+        return bank->getMipmap(WavetableBank::Shape::sine);
+    }
+
+    juce::var benchmarkWavetable(double sampleRate, double seconds)
+    {
+        Wavetable wavetable(getSine());
+        auto numSamples = (int)(sampleRate * seconds);
+        auto increment = 440.0f / (float)sampleRate;
+        auto phase = 0.0f;
+        auto sum = 0.0f;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            phase += increment;
+            phase -= (int)phase;
+            sum += wavetable.getNextSample(phase);
+        }
+
+        auto elapsed = secondsSince(start);
+        sink = sum;
+
+        return makeResult("Wavetable::getNextSample", sampleRate, elapsed, numSamples, seconds);
+    }
+
+    juce::var benchmarkWavetableBlock(double sampleRate, Wavetable::Interpolation interpolation, double seconds)
+    {
+        static const char* const names[] = { "none", "linear", "hermite", "lagrange" };
+
+        Wavetable wavetable(getSine());
+        wavetable.setInterpolation(interpolation);
+
+        constexpr int blockSize = 256;
+        std::vector<float> phases((size_t)blockSize), block((size_t)blockSize);
+        auto numBlocks = (int)(sampleRate * seconds) / blockSize;
+        auto increment = 440.0f / (float)sampleRate;
+        auto phase = 0.0f;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            for (auto& p : phases)
+            {
+                phase += increment;
+                phase -= (int)phase;
+                p = phase;
+            }
+
+            wavetable.processBlock(phases.data(), block.data(), blockSize);
+        }
+
+        auto elapsed = secondsSince(start);
+        sink = block[0];
+
+        auto result = makeResult("Wavetable::processBlock", sampleRate, elapsed, (double)numBlocks * blockSize, seconds);
+        result.getDynamicObject()->setProperty("interpolation", names[(int)interpolation]);
+        return result;
+    }
+
+    void setupPulsar(Pulsar& pulsar, double sampleRate, float formant, float index)
+    {
+        pulsar.setSampleRate(sampleRate);
+        pulsar.setFundamental(110.0f, false);
+        pulsar.setPeriod(2.0f, 1.2f, false);
+        pulsar.setFormant(formant, false);
+        pulsar.setIndex(index, false);
+        pulsar.setStochasticMasking(0);
+    }
+
+    juce::var benchmarkPulsarSample(double sampleRate, float formant, float index, double seconds)
+    {
+        Pulsar pulsar(getSine());
+        setupPulsar(pulsar, sampleRate, formant, index);
+
+        auto numSamples = (int)(sampleRate * seconds);
+        auto sum = 0.0f;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numSamples; ++i)
+            sum += pulsar.getNextSample((float)sampleRate);
+
+        auto elapsed = secondsSince(start);
+        sink = sum;
+
+        auto result = makeResult("Pulsar::getNextSample", sampleRate, elapsed, numSamples, seconds);
+        result.getDynamicObject()->setProperty("formant", formant);
+        result.getDynamicObject()->setProperty("index", index);
+        return result;
+    }
+
+    juce::var benchmarkPulsarBlock(double sampleRate, int blockSize, float formant, float index, int numPulsarets,
+                                   Pulsar::PhaseMode phaseMode, double seconds)
+    {
+        Pulsar pulsar(getSine(), WindowTables::Shape::hann, numPulsarets);
+        setupPulsar(pulsar, sampleRate, formant, index);
+        pulsar.setPhaseMode(phaseMode);
+
+        std::vector<float> block((size_t)blockSize);
+        auto numBlocks = (int)(sampleRate * seconds) / blockSize;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+            pulsar.renderBlock(block.data(), blockSize);
+
+        auto elapsed = secondsSince(start);
+        sink = block[0];
+
+        auto name = juce::String("Pulsar::renderBlock") + (phaseMode == Pulsar::PhaseMode::fixedPoint ? " (fixed point)" : "");
+        auto result = makeResult(name, sampleRate, elapsed, (double)numBlocks * blockSize, seconds);
+        result.getDynamicObject()->setProperty("blockSize", blockSize);
+        result.getDynamicObject()->setProperty("formant", formant);
+        result.getDynamicObject()->setProperty("index", index);
+        result.getDynamicObject()->setProperty("pulsarets", numPulsarets);
+        return result;
+    }
+
+    /* every operator routing at one block size, against the parallel frequency modulation of renderBlock above. */
+    juce::var benchmarkPulsarRouting(double sampleRate, float formant, float index, Pulsar::Routing routing,
+                                     Pulsar::Modulation modulation, double seconds)
+    {
+        static const char* const routingNames[] = { "parallel", "serial", "feedback" };
+
+        Pulsar pulsar(getSine());
+        setupPulsar(pulsar, sampleRate, formant, index);
+        pulsar.setModulation(routing, modulation);
+        pulsar.setFeedback(0.2f);
+
+        constexpr int blockSize = 256;
+        std::vector<float> block((size_t)blockSize);
+        auto numBlocks = (int)(sampleRate * seconds) / blockSize;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+            pulsar.renderBlock(block.data(), blockSize);
+
+        auto elapsed = secondsSince(start);
+        sink = block[0];
+
+        auto result = makeResult("Pulsar::renderBlock routing", sampleRate, elapsed, (double)numBlocks * blockSize, seconds);
+        auto* object = result.getDynamicObject();
+        object->setProperty("routing", routingNames[(int)routing]);
+        object->setProperty("modulation", modulation == Pulsar::Modulation::phase ? "phase" : "frequency");
+        object->setProperty("formant", formant);
+        object->setProperty("index", index);
+        return result;
+    }
+
+    /*
+    * renderBlock with and without skipping the silence after each pulsaret, at one block size.
+    * The formant sets the duty cycle, a formant of 0.1 sounds for a tenth of each pulse.
+    */
+    juce::var benchmarkPulsarDutyCycle(double sampleRate, float formant, float index, int numPulsarets, bool skipSilence,
+                                       double seconds)
+    {
+        Pulsar pulsar(getSine(), WindowTables::Shape::hann, numPulsarets);
+        setupPulsar(pulsar, sampleRate, formant, index);
+        pulsar.setSkipSilence(skipSilence);
+
+        constexpr int blockSize = 256;
+        std::vector<float> block((size_t)blockSize);
+        auto numBlocks = (int)(sampleRate * seconds) / blockSize;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+            pulsar.renderBlock(block.data(), blockSize);
+
+        auto elapsed = secondsSince(start);
+        sink = block[0];
+
+        auto result = makeResult("Pulsar::renderBlock duty cycle", sampleRate, elapsed, (double)numBlocks * blockSize, seconds);
+        auto* object = result.getDynamicObject();
+        object->setProperty("skipSilence", skipSilence);
+        object->setProperty("formant", formant);
+        object->setProperty("index", index);
+        object->setProperty("pulsarets", numPulsarets);
+        return result;
+    }
+
+    /*
+    * not a timing, skipping the silence must not change a single sample. Renders every window shape
+    * in both phase modes with skipSilence off and on at a few fundamentals, so pulsarets close at every
+    * point of a chunk, and compares them.
+    */
+    juce::var checkSkipSilence(double sampleRate, float formant, float index, int numPulsarets)
+    {
+        constexpr int blockSize = 256;
+        std::vector<float> expected((size_t)blockSize), block((size_t)blockSize);
+        auto numBlocks = (int)(sampleRate * 0.5) / blockSize;
+        auto maxDifference = 0.0f;
+        auto numMismatches = 0;
+
+        for (int shape = 0; shape < WindowTables::numShapes; ++shape)
+        {
+            for (auto phaseMode : { Pulsar::PhaseMode::floatingPoint, Pulsar::PhaseMode::fixedPoint })
+            {
+                for (auto fundamental : { 37.0f, 110.0f, 293.0f })
+                {
+                    Pulsar reference(getSine(), (WindowTables::Shape)shape, numPulsarets);
+                    Pulsar skipping(getSine(), (WindowTables::Shape)shape, numPulsarets);
+                    auto difference = 0.0f;
+
+                    for (auto* pulsar : { &reference, &skipping })
+                    {
+                        setupPulsar(*pulsar, sampleRate, formant, index);
+                        pulsar->setFundamental(fundamental, false);
+                        pulsar->setPhaseMode(phaseMode);
+                    }
+
+                    reference.setSkipSilence(false);
+                    skipping.setSkipSilence(true);
+
+                    for (int i = 0; i < numBlocks; ++i)
+                    {
+                        reference.renderBlock(expected.data(), blockSize);
+                        skipping.renderBlock(block.data(), blockSize);
+
+                        for (int n = 0; n < blockSize; ++n)
+                            difference = juce::jmax(difference, std::abs(expected[(size_t)n] - block[(size_t)n]));
+                    }
+
+                    maxDifference = juce::jmax(maxDifference, difference);
+
+                    if (difference > 0.0f)
+                        ++numMismatches;
+                }
+            }
+        }
+
+        skipSilenceMismatches += numMismatches;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("benchmark", "Pulsar::renderBlock skip silence check");
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("formant", formant);
+        result->setProperty("index", index);
+        result->setProperty("pulsarets", numPulsarets);
+        result->setProperty("maxDifference", maxDifference);
+        result->setProperty("mismatches", numMismatches);
+        return juce::var(result);
+    }
+
+    /*
+    * one cloud at 10000 grains per second, each as long as the pulsar's pulsaret at this formant.
+    * grainsPerCpuSecond is how many of those grains one core renders in a second.
+    */
+    juce::var benchmarkCloud(double sampleRate, int blockSize, float formant, double seconds)
+    {
+        constexpr float density = 10000.0f, fundamental = 110.0f;
+
+        PulsaretCloud cloud(getSine());
+        cloud.prepare(sampleRate);
+        cloud.setDensity(density);
+        cloud.setPulsaret(fundamental * 2.0f / formant, formant / fundamental);
+        cloud.setSpread(1.0f);
+        cloud.setWidth(1.0f);
+        cloud.setSeed(1);
+
+        std::vector<float> left((size_t)blockSize), right((size_t)blockSize);
+        auto numBlocks = (int)(sampleRate * seconds) / blockSize;
+        auto maxActiveGrains = 0;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            const RealtimeCheck::ScopedSection realtime;
+            juce::FloatVectorOperations::clear(left.data(), blockSize);
+            juce::FloatVectorOperations::clear(right.data(), blockSize);
+            cloud.renderBlock(left.data(), right.data(), blockSize);
+            maxActiveGrains = juce::jmax(maxActiveGrains, cloud.getNumActiveGrains());
+        }
+
+        auto elapsed = secondsSince(start);
+        sink = left[0] + right[0];
+
+        auto result = makeResult("PulsaretCloud::renderBlock", sampleRate, elapsed, (double)numBlocks * blockSize, seconds);
+        auto* object = result.getDynamicObject();
+        object->setProperty("blockSize", blockSize);
+        object->setProperty("formant", formant);
+        object->setProperty("density", density);
+        object->setProperty("maxActiveGrains", maxActiveGrains);
+        object->setProperty("droppedGrains", cloud.getNumGrainsDropped());
+        object->setProperty("grainsPerCpuSecond", (double)cloud.getNumGrainsStarted() / elapsed);
+        return result;
+    }
+
+    /* with panning on the pulsarets are spread across all the channels, see PanMatrix. */
+    juce::var benchmarkVoices(double sampleRate, int blockSize, float formant, float index, int numVoices, int oversampling,
+                              int numChannels, bool panning, double seconds)
+    {
+        juce::SynthesiserSound::Ptr sound(new PulsarSound());
+        juce::OwnedArray<PulsarVoice> voices;
+
+        PulsarParameters parameters;
+        parameters.attack       = 0.001f;
+        parameters.decay        = 0.001f;
+        parameters.sustain      = 1.0f;
+        parameters.release      = 0.1f;
+        parameters.fundamental  = 110.0f;
+        parameters.period       = 2.0f;
+        parameters.periodSpread = 1.2f;
+        parameters.formant      = formant;
+        parameters.index        = index;
+
+        /* a threshold of 0 keeps every voice at the full factor, the worst case. */
+        parameters.oversampling = oversampling;
+        parameters.oversamplingThreshold = 0.0f;
+        parameters.panning = panning;
+        parameters.panSpread = 1.0f;
+
+        for (int v = 0; v < numVoices; ++v)
+        {
+            auto* voice = voices.add(new PulsarVoice(parameters, v));
+            voice->setCurrentPlaybackSampleRate(sampleRate);
+            voice->startNote(48 + v % 24, 1.0f, sound.get(), 0);
+        }
+
+        juce::AudioSampleBuffer buffer(numChannels, blockSize);
+        auto numBlocks = (int)(sampleRate * seconds) / blockSize;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            const RealtimeCheck::ScopedSection realtime;
+            buffer.clear();
+
+            for (auto* voice : voices)
+                voice->renderNextBlock(buffer, 0, blockSize);
+        }
+
+        auto elapsed = secondsSince(start);
+        sink = buffer.getSample(0, 0);
+
+        auto voiceSamples = (double)numBlocks * blockSize * numVoices;
+        auto result = makeResult("PulsarVoice::renderNextBlock", sampleRate, elapsed, voiceSamples, seconds);
+        auto* object = result.getDynamicObject();
+        object->setProperty("blockSize", blockSize);
+        object->setProperty("formant", formant);
+        object->setProperty("index", index);
+        object->setProperty("voices", numVoices);
+        object->setProperty("oversampling", oversampling);
+        object->setProperty("channels", numChannels);
+        object->setProperty("panning", panning);
+
+        /* a core runs out of time once the real time factor of all the voices together reaches 1. */
+        object->setProperty("maxVoicesPerCore", (int)(numVoices * seconds / elapsed));
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+    juce::ScopedNoDenormals noDenormals;
+
+    BenchmarkSettings settings;
+    settings.seconds     = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : settings.seconds;
+    settings.sampleRates = parseList(args, "--rates",    settings.sampleRates);
+    settings.blockSizes  = parseList(args, "--blocks",   settings.blockSizes);
+    settings.formants    = parseList(args, "--formants", settings.formants);
+    settings.indices     = parseList(args, "--indices",  settings.indices);
+    settings.voiceCounts = parseList(args, "--voices",   settings.voiceCounts);
+    settings.pulsaretCounts = parseList(args, "--pulsarets", settings.pulsaretCounts);
+    settings.oversamplingFactors = parseList(args, "--oversampling", settings.oversamplingFactors);
+    settings.channelCounts = parseList(args, "--channels", settings.channelCounts);
+    settings.panningModes = parseList(args, "--panning", settings.panningModes);
+
+    /* the blocks are counted by dividing by the block size, a size of 0 (or a word, which parses as 0) would divide by zero. */
+    for (auto blockSize : settings.blockSizes)
+    {
+        if ((int)blockSize < 1)
+        {
+            std::cerr << "--blocks takes block sizes of 1 sample or more" << std::endl;
+            printUsage(args.executableName);
+            return 1;
+        }
+    }
+
+    juce::Array<juce::var> results;
+
+    for (auto sampleRate : settings.sampleRates)
+    {
+        results.add(benchmarkWavetable(sampleRate, settings.seconds));
+
+        for (auto interpolation : { Wavetable::Interpolation::none, Wavetable::Interpolation::linear,
+                                    Wavetable::Interpolation::hermite, Wavetable::Interpolation::lagrange })
+            results.add(benchmarkWavetableBlock(sampleRate, interpolation, settings.seconds));
+
+        for (auto formant : settings.formants)
+        {
+            /* the cloud has no FM, so no index either. */
+            for (auto blockSize : settings.blockSizes)
+                results.add(benchmarkCloud(sampleRate, (int)blockSize, (float)formant, settings.seconds));
+
+            for (auto index : settings.indices)
+            {
+                results.add(benchmarkPulsarSample(sampleRate, (float)formant, (float)index, settings.seconds));
+
+                for (auto routing : { Pulsar::Routing::parallel, Pulsar::Routing::serial, Pulsar::Routing::feedback })
+                {
+                    for (auto modulation : { Pulsar::Modulation::frequency, Pulsar::Modulation::phase })
+                        results.add(benchmarkPulsarRouting(sampleRate, (float)formant, (float)index, routing, modulation, settings.seconds));
+                }
+
+                for (auto numPulsarets : settings.pulsaretCounts)
+                {
+                    results.add(checkSkipSilence(sampleRate, (float)formant, (float)index, (int)numPulsarets));
+
+                    for (auto skipSilence : { false, true })
+                        results.add(benchmarkPulsarDutyCycle(sampleRate, (float)formant, (float)index, (int)numPulsarets,
+                                                             skipSilence, settings.seconds));
+                }
+
+                for (auto blockSize : settings.blockSizes)
+                {
+                    for (auto numPulsarets : settings.pulsaretCounts)
+                    {
+                        for (auto phaseMode : { Pulsar::PhaseMode::floatingPoint, Pulsar::PhaseMode::fixedPoint })
+                            results.add(benchmarkPulsarBlock(sampleRate, (int)blockSize, (float)formant, (float)index,
+                                                             (int)numPulsarets, phaseMode, settings.seconds));
+                    }
+
+                    for (auto numVoices : settings.voiceCounts)
+                    {
+                        for (auto oversampling : settings.oversamplingFactors)
+                        {
+                            for (auto numChannels : settings.channelCounts)
+                            {
+                                for (auto panning : settings.panningModes)
+                                    results.add(benchmarkVoices(sampleRate, (int)blockSize, (float)formant, (float)index, (int)numVoices,
+                                                                (int)oversampling, (int)numChannels, panning != 0.0, settings.seconds));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("juceVersion", juce::SystemStats::getJUCEVersion());
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("buildDate", juce::String(__DATE__) + " " + __TIME__);
+    report->setProperty("seconds", settings.seconds);
+    report->setProperty("results", results);
+
+    /* always 0 unless built with PULSAR_RT_CHECKS, times from such a build are not comparable. */
+    report->setProperty("realtimeViolations", RealtimeCheck::getNumViolations());
+    report->setProperty("skipSilenceMismatches", skipSilenceMismatches);
+
+    auto json = juce::JSON::toString(juce::var(report));
+
+    if (args.containsOption("--out"))
+    {
+        auto outputFile = args.getFileForOption("--out");
+
+        if (!outputFile.replaceWithText(json))
+        {
+            std::cerr << "could not write " << outputFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    if (skipSilenceMismatches > 0)
+    {
+        std::cerr << skipSilenceMismatches << " renders changed with skipSilence on" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "HalfbandDecimator.h"
+
+namespace
+{
+    /*
+    * Kaiser windowed sinc halfband filters, normalised to unity gain at DC.
+    * lastCoefficients: 39 taps, beta 7.5, flat to 0.38 of the output rate and -62dB from 0.62.
+    * shortCoefficients: 19 taps, beta 7, flat to 0.25 of the output rate and -68dB from 0.75.
+    */
+    const float lastCoefficients[] =
+    {
+         3.152314750e-01f, -9.720765562e-02f, 4.979171796e-02f, -2.786788112e-02f, 1.544334229e-02f,
+        -8.060067515e-03f,  3.792708920e-03f, -1.515329363e-03f, 4.541608518e-04f, -6.247142035e-05f
+    };
+
+    const float shortCoefficients[] =
+    {
+         3.058879283e-01f, -7.334108428e-02f, 2.156205938e-02f, -4.318746999e-03f, 2.098435739e-04f
+    };
+}
+
+HalfbandDecimator::HalfbandDecimator(const float* coefficientsToUse, int numCoefficientsToUse)
+    : coefficients(coefficientsToUse),
+    numCoefficients(numCoefficientsToUse)
+{
+}
+
+HalfbandDecimator::~HalfbandDecimator()
+{
+}
+
+void HalfbandDecimator::prepare(int maxNumOutputSamples)
+{
+    even.assign((size_t)(2 * numCoefficients - 1 + maxNumOutputSamples), 0.0f);
+    odd.assign((size_t)(numCoefficients + maxNumOutputSamples), 0.0f);
+    pairSum.assign((size_t)maxNumOutputSamples, 0.0f);
+}
+
+void HalfbandDecimator::reset()
+{
+    std::fill(even.begin(), even.end(), 0.0f);
+    std::fill(odd.begin(), odd.end(), 0.0f);
+}
+
+int HalfbandDecimator::getLatency() const
+{
+    return 2 * numCoefficients - 1;
+}
+
+void HalfbandDecimator::process(const float* input, float* output, int numOutputSamples)
+{
+    jassert((size_t)numOutputSamples <= pairSum.size());
+
+    const auto evenHistory = 2 * numCoefficients - 1;
+    const auto oddHistory = numCoefficients;
+
+    for (int m = 0; m < numOutputSamples; ++m)
+    {
+        even[(size_t)(evenHistory + m)] = input[2 * m];
+        odd [(size_t)(oddHistory + m)]  = input[2 * m + 1];
+    }
+
+    /*
+    * y[m] = 0.5 * odd[m - K] + sum over j of c[j] * (even[m - K + 1 + j] + even[m - K - j]), K = numCoefficients.
+    * evenAt and oddAt point at sample m = 0, the history sits before them.
+    */
+    auto* evenAt = even.data() + evenHistory;
+    auto* oddAt = odd.data() + oddHistory;
+
+    juce::FloatVectorOperations::multiply (output, oddAt - numCoefficients, 0.5f, numOutputSamples);
+
+    for (int j = 0; j < numCoefficients; ++j)
+    {
+        juce::FloatVectorOperations::add (pairSum.data(), evenAt + 1 + j - numCoefficients, evenAt - numCoefficients - j, numOutputSamples);
+        juce::FloatVectorOperations::addWithMultiply (output, pairSum.data(), coefficients[j], numOutputSamples);
+    }
+
+    /* keep the end of this block as the history for the next, the ranges can overlap. */
+    std::memmove(even.data(), even.data() + numOutputSamples, sizeof(float) * (size_t)evenHistory);
+    std::memmove(odd.data(),  odd.data()  + numOutputSamples, sizeof(float) * (size_t)oddHistory);
+}
+
+//==============================================================================
+
+OversamplingDecimator::OversamplingDecimator()
+    : firstStage(shortCoefficients, juce::numElementsInArray(shortCoefficients)),
+    secondStage(shortCoefficients, juce::numElementsInArray(shortCoefficients)),
+    lastStage(lastCoefficients, juce::numElementsInArray(lastCoefficients))
+{
+}
+
+OversamplingDecimator::~OversamplingDecimator()
+{
+}
+
+void OversamplingDecimator::prepare(int maxNumOutputSamples)
+{
+    firstStage.prepare(maxNumOutputSamples * 4);
+    secondStage.prepare(maxNumOutputSamples * 2);
+    lastStage.prepare(maxNumOutputSamples);
+
+    paddingBuffer.assign((size_t)(latencySamples * maxFactor + maxNumOutputSamples * maxFactor), 0.0f);
+    firstBuffer.assign((size_t)(maxNumOutputSamples * 4), 0.0f);
+    secondBuffer.assign((size_t)(maxNumOutputSamples * 2), 0.0f);
+    silence.assign((size_t)(maxNumOutputSamples * maxFactor), 0.0f);
+
+    setFactor(factor);
+}
+
+void OversamplingDecimator::setFactor(int newFactor)
+{
+    jassert(newFactor == 1 || newFactor == 2 || newFactor == 4 || newFactor == 8);
+    factor = newFactor;
+
+    /* the delay of the stages in use at the input rate, each stage runs at half the rate of the one before. */
+    auto stageDelay = 0, stageScale = 1;
+
+    if (factor >= 8)
+    {
+        stageDelay += firstStage.getLatency() * stageScale;
+        stageScale *= 2;
+    }
+
+    if (factor >= 4)
+    {
+        stageDelay += secondStage.getLatency() * stageScale;
+        stageScale *= 2;
+    }
+
+    if (factor >= 2)
+        stageDelay += lastStage.getLatency() * stageScale;
+
+    padding = latencySamples * factor - stageDelay;
+    jassert(padding >= 0);
+
+    reset();
+}
+
+int OversamplingDecimator::getFactor() const
+{
+    return factor;
+}
+
+void OversamplingDecimator::reset()
+{
+    firstStage.reset();
+    secondStage.reset();
+    lastStage.reset();
+    std::fill(paddingBuffer.begin(), paddingBuffer.end(), 0.0f);
+}
+
+void OversamplingDecimator::process(const float* input, float* output, int numOutputSamples)
+{
+    auto numInputSamples = numOutputSamples * factor;
+    jassert((size_t)(padding + numInputSamples) <= paddingBuffer.size());
+
+    /* the padding delay, then the stages from the highest rate down. */
+    juce::FloatVectorOperations::copy (paddingBuffer.data() + padding, input, numInputSamples);
+    const float* stageInput = paddingBuffer.data();
+
+    if (factor >= 8)
+    {
+        firstStage.process(stageInput, firstBuffer.data(), numOutputSamples * 4);
+        stageInput = firstBuffer.data();
+    }
+
+    if (factor >= 4)
+    {
+        secondStage.process(stageInput, secondBuffer.data(), numOutputSamples * 2);
+        stageInput = secondBuffer.data();
+    }
+
+    if (factor >= 2)
+        lastStage.process(stageInput, output, numOutputSamples);
+    else
+        juce::FloatVectorOperations::copy (output, stageInput, numOutputSamples);
+
+    std::memmove(paddingBuffer.data(), paddingBuffer.data() + numInputSamples, sizeof(float) * (size_t)padding);
+}
+
+void OversamplingDecimator::flush(float* output, int numOutputSamples)
+{
+    process(silence.data(), output, numOutputSamples);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+* One halve of the sample rate, a linear phase halfband FIR in polyphase form.
+* Every other tap of a halfband filter is zero and the centre tap is 0.5, so the input is split into its
+* even and odd samples and each output is 0.5 * odd + (the symmetric even taps), at half the input rate.
+* Each tap pair is applied to the whole block at once with juce::FloatVectorOperations.
+*/
+class HalfbandDecimator
+{
+public:
+    /* coefficients are the nonzero taps to one side of the centre, nearest first. */
+    HalfbandDecimator(const float* coefficientsToUse, int numCoefficientsToUse);
+    ~HalfbandDecimator();
+
+    /* allocates the history and scratch, call before processing. */
+    void prepare(int maxNumOutputSamples);
+    void reset();
+
+    /* input holds 2 * numOutputSamples samples. */
+    void process(const float* input, float* output, int numOutputSamples);
+
+    /* delay in input samples, the centre tap. */
+    int getLatency() const;
+private:
+    const float* coefficients;
+    int numCoefficients;
+
+    /* the last 2 * numCoefficients - 1 even samples and numCoefficients odd samples, then the new block. */
+    std::vector<float> even, odd, pairSum;
+};
+
+/*
+* Brings a voice rendered at 1, 2, 4 or 8 times the sample rate back down, with cascaded halfband stages.
+* The delay is latencySamples whatever the factor, shorter chains are padded with whole samples,
+* so a voice can change factor while it plays without its timing moving.
+*/
+class OversamplingDecimator
+{
+public:
+    OversamplingDecimator();
+    ~OversamplingDecimator();
+
+    static constexpr int maxFactor = 8;
+    static constexpr int latencySamples = 13;
+
+    void prepare(int maxNumOutputSamples);
+
+    /* 1, 2, 4 or 8. Clears the filters. */
+    void setFactor(int newFactor);
+    int getFactor() const;
+    void reset();
+
+    /* input holds getFactor() * numOutputSamples samples. */
+    void process(const float* input, float* output, int numOutputSamples);
+
+    /* processes silence, lets what is left in the filters out after the voice has moved to another decimator. */
+    void flush(float* output, int numOutputSamples);
+private:
+    /* the 8x to 4x and 4x to 2x stages, the band they must keep is narrow so they are shorter. */
+    HalfbandDecimator firstStage, secondStage;
+
+    /* 2x to 1x, the audible band runs right up to its transition. */
+    HalfbandDecimator lastStage;
+
+    int factor = 1;
+
+    /* pads the delay of the stages in use up to latencySamples, at the input rate. */
+    int padding = latencySamples;
+    std::vector<float> paddingBuffer, firstBuffer, secondBuffer, silence;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OversamplingDecimator)
+};
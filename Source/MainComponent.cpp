@@ -2,7 +2,6 @@
 
 //==============================================================================
 MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyboardComponent::horizontalKeyboard),
-                                 bufferSize(1024),
                                  synthAudioSource(keyBoardState),
                                  ampAdsr(synthAudioSource)
 {
@@ -27,7 +26,7 @@ MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyb
     fundamentalSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 100, 30);
     fundamentalSlider.setSliderStyle(juce::Slider::LinearVertical);
     fundamentalSlider.addListener(this);
-    fundamentalSlider.onValueChange = [this] { fundamental = (float)fundamentalSlider.getValue(); };
+    fundamentalSlider.onValueChange = [this] { fundamental = (float)fundamentalSlider.getValue(); synthAudioSource.setFundamental(fundamental); };
     fundamentalSlider.setMouseClickGrabsKeyboardFocus(false);
 
     addAndMakeVisible(periodSlider);
@@ -44,7 +43,7 @@ MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyb
     periodSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 100, 30);
     periodSlider.setSliderStyle(juce::Slider::LinearVertical);
     periodSlider.addListener(this);
-    periodSlider.onValueChange = [this] { period = (float)periodSlider.getValue(); };
+    periodSlider.onValueChange = [this] { period = (float)periodSlider.getValue(); synthAudioSource.setPeriod(period); };
     periodSlider.setMouseClickGrabsKeyboardFocus(false);
 
     addAndMakeVisible(periodSpreadSlider);
@@ -61,7 +60,7 @@ MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyb
     periodSpreadSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 100, 30);
     periodSpreadSlider.setSliderStyle(juce::Slider::LinearVertical);
     periodSpreadSlider.addListener(this);
-    periodSpreadSlider.onValueChange = [this] { periodSpread = (float)periodSpreadSlider.getValue(); };
+    periodSpreadSlider.onValueChange = [this] { periodSpread = (float)periodSpreadSlider.getValue(); synthAudioSource.setPeriodSpread(periodSpread); };
     periodSpreadSlider.setMouseClickGrabsKeyboardFocus(false);
 
     addAndMakeVisible(formantSlider);
@@ -79,7 +78,7 @@ MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyb
     formantSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 100, 30);
     formantSlider.setSliderStyle(juce::Slider::LinearVertical);
     formantSlider.addListener(this);
-    formantSlider.onValueChange = [this] { formant = (float)formantSlider.getValue(); };
+    formantSlider.onValueChange = [this] { formant = (float)formantSlider.getValue(); synthAudioSource.setFormant(formant); };
     formantSlider.setMouseClickGrabsKeyboardFocus(false);
 
     addAndMakeVisible(indexSlider);
@@ -96,7 +95,7 @@ MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyb
     indexSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 100, 30);
     indexSlider.setSliderStyle(juce::Slider::LinearVertical);
     indexSlider.addListener(this);
-    indexSlider.onValueChange = [this] { index = (float)indexSlider.getValue(); };
+    indexSlider.onValueChange = [this] { index = (float)indexSlider.getValue(); synthAudioSource.setIndex(index); };
     indexSlider.setMouseClickGrabsKeyboardFocus(false);
 
     /* will not require interpolation */
@@ -114,37 +113,50 @@ MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyb
     stochasticMaskingSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 100, 30);
     stochasticMaskingSlider.setSliderStyle(juce::Slider::LinearVertical);
     stochasticMaskingSlider.addListener(this);
-    stochasticMaskingSlider.onValueChange = [this] { maskingPercentage = (int)stochasticMaskingSlider.getValue(); };
+    stochasticMaskingSlider.onValueChange = [this] { maskingPercentage = (int)stochasticMaskingSlider.getValue(); synthAudioSource.setMasking(maskingPercentage); };
     stochasticMaskingSlider.setMouseClickGrabsKeyboardFocus(false);
 
     addAndMakeVisible(keyboardToggle);
-    keyboardToggle.onClick = [this] { keyboardControl = keyboardToggle.getToggleState();  };
+    keyboardToggle.onClick = [this] { keyboardControl = keyboardToggle.getToggleState(); synthAudioSource.setKeyboardControl(keyboardControl); };
     keyboardToggle.setMouseClickGrabsKeyboardFocus(false);
 
-    addAndMakeVisible(keyBoardComponent);
+    addAndMakeVisible(loadLabel);
+    loadLabel.setJustificationType(juce::Justification::centredRight);
+    loadLabel.setMouseClickGrabsKeyboardFocus(false);
 
-    setSize(800, 500);
-    setAudioChannels(0, 2);
+    addAndMakeVisible(telemetryToggle);
+    telemetryToggle.setMouseClickGrabsKeyboardFocus(false);
+    telemetryToggle.onClick = [this]
+    {
+        if (!telemetryToggle.getToggleState())
+        {
+            telemetryWriter.stop();
+            return;
+        }
 
-    // give focus to the keyboard.
-    startTimer(40);
+        auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("pulsar_timings.csv");
 
-    buffer.setSize(1, (int)bufferSize + 1);
+        if (!telemetryWriter.start(file))
+            telemetryToggle.setToggleState(false, juce::dontSendNotification);
+    };
 
-    auto* _samples = buffer.getWritePointer(0);
+    addAndMakeVisible(keyBoardComponent);
 
-    auto angleDelta = juce::MathConstants<double>::twoPi / (double)(tableSize - 1);
-    auto currentAngle = 0.0;
+    /* the sliders only publish when they move, so send the starting values once. */
+    synthAudioSource.amplitudeEnvelope  (ampAdsr.getAttack(), ampAdsr.getDecay(), ampAdsr.getSustain(), ampAdsr.getRelease());
+    synthAudioSource.setKeyboardControl (keyboardControl);
+    synthAudioSource.setFundamental     (fundamental);
+    synthAudioSource.setPeriod          (period);
+    synthAudioSource.setPeriodSpread    (periodSpread);
+    synthAudioSource.setFormant         (formant);
+    synthAudioSource.setIndex           (index);
+    synthAudioSource.setMasking         (maskingPercentage);
 
-    for (int i = 0; i < bufferSize; ++i)
-    {
-        // juce::Random random;
-        auto sample = std::sin(currentAngle);
-        _samples[i] = float(sample);
-        currentAngle += angleDelta;
-    }
+    setSize(800, 500);
+    setAudioChannels(0, 2);
 
-    _samples[bufferSize] = _samples[0];
+    // give focus to the keyboard, then keep the load meter up to date.
+    startTimer(40);
 
     // Some platforms require permissions to open input channels so request that here
     if (juce::RuntimePermissions::isRequired(juce::RuntimePermissions::recordAudio)
@@ -163,29 +175,29 @@ MainComponent::MainComponent() : keyBoardComponent(keyBoardState, juce::MidiKeyb
 MainComponent::~MainComponent()
 {
     shutdownAudio();
+    telemetryWriter.stop();
+
+    if (RealtimeCheck::getNumViolations() > 0)
+        juce::Logger::writeToLog(RealtimeCheck::getReport());
 }
 
 //==============================================================================
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
+    /* the device's buffer has a channel for each active input or output, whichever there are more of. */
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+        synthAudioSource.setNumOutputChannels(juce::jmax(device->getActiveInputChannels().countNumberOfSetBits(),
+                                                         device->getActiveOutputChannels().countNumberOfSetBits()));
+
     synthAudioSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
 
     currentSampleRate = sampleRate;
-
-    // _oscillator = std::make_unique<Pulsar>(sineTable, windowTable);
 }
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    synthAudioSource.getNextAudioBlock  (bufferToFill);
-    synthAudioSource.amplitudeEnvelope  (ampAdsr.getAttack(), ampAdsr.getDecay(), ampAdsr.getSustain(), ampAdsr.getRelease());
-    synthAudioSource.setKeyboardControl (keyboardControl);
-    synthAudioSource.setFundamental     (fundamental);
-    synthAudioSource.setPeriod          (period);
-    synthAudioSource.setPeriodSpread    (periodSpread);
-    synthAudioSource.setFormant         (formant);
-    synthAudioSource.setIndex           (index);
-    synthAudioSource.setMasking         (maskingPercentage);
+    /* parameters are published from the slider callbacks, nothing to push from here. */
+    synthAudioSource.getNextAudioBlock(bufferToFill);
 }
 
 void MainComponent::releaseResources()
@@ -224,6 +236,8 @@ void MainComponent::resized()
     int toggleHeight = 30;
 
     keyboardToggle.setBounds(0, 0, toggleWidth, toggleHeight);
+    telemetryToggle.setBounds(width - toggleWidth * 2, 0, toggleWidth * 2, toggleHeight);
+    loadLabel.setBounds(width - adsrWidth, toggleHeight, adsrWidth, toggleHeight);
     ampAdsr.setBounds(width / 2 - (adsrWidth / 2), 0, adsrWidth, adsrHeight - margin);
 
     fundamentalSlider.setBounds       (0,                  adsrHeight, sliderWidth, sliderHeight - margin);
@@ -242,9 +256,28 @@ void MainComponent::sliderValueChanged(juce::Slider*)
 //==============================================================================
 void MainComponent::timerCallback()
 {
-    // give the computer keyboard focus to this component. 
-    keyBoardComponent.grabKeyboardFocus();
-    keyBoardComponent.setKeyPressBaseOctave(3);
-   
-    stopTimer();
+    // give the computer keyboard focus to this component, once.
+    if (!keyboardFocusGiven)
+    {
+        keyBoardComponent.grabKeyboardFocus();
+        keyBoardComponent.setKeyPressBaseOctave(3);
+        keyboardFocusGiven = true;
+    }
+
+    updateLoadMeter();
+}
+
+/* the peak since the last tick, so a single slow block still shows. Overruns are blocks that took longer than they last. */
+void MainComponent::updateLoadMeter()
+{
+    auto& telemetry = synthAudioSource.getTelemetry();
+    auto peak = telemetry.getAndResetPeakLoad();
+
+    loadLabel.setText("CPU " + juce::String(juce::roundToInt(peak * 100.0f)) + "%  near misses "
+                      + juce::String(telemetry.getNumNearMisses()) + "  overruns " + juce::String(telemetry.getNumOverruns())
+                      + "  late voices " + juce::String(telemetry.getNumLateVoiceWaits())
+                      + "  xruns " + juce::String(deviceManager.getXRunCount()),
+                      juce::dontSendNotification);
+    loadLabel.setColour(juce::Label::textColourId, peak > RenderTelemetry::nearMissLoad ? juce::Colours::red
+                                                                                         : juce::Colours::white);
 }
\ No newline at end of file
@@ -52,18 +52,6 @@ private:
     float level = 0.25f;
     double currentSampleRate = 0;
 
-    const unsigned int tableSize = 1 << 9;
-
-    juce::AudioSampleBuffer sineTable;
-    juce::AudioSampleBuffer windowTable;
-
-    /* use a JUCE owned array */
-    std::unique_ptr<Pulsar> _oscillator;
-
-    juce::AudioBuffer<float> buffer;
-    int bufferSize;
-    int writePos = 0;
-
     float fundamental = 220.0f;
     float period = 1.0f, periodSpread = 1.0f;
     float formant = 1.0f;
@@ -90,6 +78,13 @@ private:
 
     bool keyboardControl = false;
 
+    /* cpu load of the audio callback, polled by the timer. The toggle logs every block to a csv. */
+    void updateLoadMeter();
+    juce::Label loadLabel;
+    juce::ToggleButton telemetryToggle { "Log timings" };
+    TelemetryWriter telemetryWriter { synthAudioSource.getTelemetry() };
+    bool keyboardFocusGiven = false;
+
     Smooth fundamentalSmooth;
     Smooth periodSmooth, periodSpreadSmooth;
     Smooth formantSmooth, formantSpreadSmooth;
@@ -0,0 +1,167 @@
+#include "MappedWavetableBank.h"
+
+MappedWavetableBank::MappedWavetableBank()
+{
+}
+
+MappedWavetableBank::~MappedWavetableBank()
+{
+}
+
+juce::Result MappedWavetableBank::open(const juce::File& fileToOpen, int frameSizeToUse)
+{
+    const juce::ScopedLock sl(lock);
+
+    reader.reset();
+    carriers.clear();
+    windows.clear();
+    numFrames = 0;
+
+    if (!fileToOpen.existsAsFile())
+        return juce::Result::fail("no such file " + fileToOpen.getFullPathName());
+
+    if (fileToOpen.hasFileExtension("wav"))
+        reader.reset(juce::WavAudioFormat().createMemoryMappedReader(fileToOpen));
+    else if (fileToOpen.hasFileExtension("aif;aiff"))
+        reader.reset(juce::AiffAudioFormat().createMemoryMappedReader(fileToOpen));
+    else
+        return juce::Result::fail("wavetables must be wav or aiff files, not " + fileToOpen.getFileName());
+
+    /* maps the file without reading it, the pages are read in as frames are converted. */
+    if (reader == nullptr || !reader->mapEntireFile())
+    {
+        reader.reset();
+        return juce::Result::fail("could not map " + fileToOpen.getFullPathName());
+    }
+
+    if (frameSizeToUse <= 0)
+        frameSizeToUse = findSerumFrameSize(fileToOpen);
+
+    if (frameSizeToUse <= 0)
+        frameSizeToUse = defaultFrameSize;
+
+    if (!juce::isPowerOfTwo(frameSizeToUse) || frameSizeToUse < 4)
+    {
+        reader.reset();
+        return juce::Result::fail("frame size " + juce::String(frameSizeToUse) + " is not a power of two");
+    }
+
+    if (reader->lengthInSamples < frameSizeToUse)
+    {
+        reader.reset();
+        return juce::Result::fail(fileToOpen.getFileName() + " is shorter than one frame");
+    }
+
+    file = fileToOpen;
+    frameSize = frameSizeToUse;
+    numFrames = (int)(reader->lengthInSamples / frameSize);
+    carriers.resize((size_t)numFrames);
+    windows.resize((size_t)numFrames);
+    scratch.setSize(1, frameSize);
+
+    return juce::Result::ok();
+}
+
+bool MappedWavetableBank::isOpen() const
+{
+    return numFrames > 0;
+}
+
+juce::File MappedWavetableBank::getFile() const
+{
+    return file;
+}
+
+int MappedWavetableBank::getNumFrames() const
+{
+    return numFrames;
+}
+
+int MappedWavetableBank::getFrameSize() const
+{
+    return frameSize;
+}
+
+const WavetableMipmap& MappedWavetableBank::getCarrier(int frame)
+{
+    const juce::ScopedLock sl(lock);
+    jassert(isOpen());
+
+    frame = juce::jlimit(0, numFrames - 1, frame);
+    auto& carrier = carriers[(size_t)frame];
+
+    if (carrier == nullptr)
+    {
+        readFrame(frame, scratch);
+        carrier = std::make_unique<WavetableMipmap>(scratch.getReadPointer(0), frameSize);
+    }
+
+    return *carrier;
+}
+
+const juce::AudioSampleBuffer& MappedWavetableBank::getWindow(int frame)
+{
+    const juce::ScopedLock sl(lock);
+    jassert(isOpen());
+
+    frame = juce::jlimit(0, numFrames - 1, frame);
+    auto& window = windows[(size_t)frame];
+
+    if (window == nullptr)
+    {
+        /* read straight into the table, then the guard sample, a copy of the first, as the readers expect. */
+        window = std::make_unique<juce::AudioSampleBuffer>(1, frameSize + 1);
+        readFrame(frame, *window);
+        window->setSample(0, frameSize, window->getSample(0, 0));
+    }
+
+    return *window;
+}
+
+/* converts whatever the file holds (16, 24 or 32 bit) to floats, only the first channel. */
+void MappedWavetableBank::readFrame(int frame, juce::AudioSampleBuffer& destination)
+{
+    reader->read(&destination, 0, frameSize, (juce::int64)frame * frameSize, true, false);
+}
+
+/*
+* Serum writes a "clm " chunk before the audio, its text starts "<!>" and the frame size, "<!>2048 ...".
+* Only the chunk headers are read on the way, never the audio.
+*/
+int MappedWavetableBank::findSerumFrameSize(const juce::File& fileToSearch)
+{
+    juce::FileInputStream in(fileToSearch);
+
+    if (!in.openedOk() || in.readInt() != (int)juce::ByteOrder::littleEndianInt("RIFF"))
+        return 0;
+
+    in.readInt();
+
+    if (in.readInt() != (int)juce::ByteOrder::littleEndianInt("WAVE"))
+        return 0;
+
+    while (!in.isExhausted())
+    {
+        auto chunkType = in.readInt();
+        auto chunkSize = (juce::int64)(juce::uint32)in.readInt();
+        auto chunkStart = in.getPosition();
+
+        if (chunkType == (int)juce::ByteOrder::littleEndianInt("clm "))
+        {
+            juce::MemoryBlock text;
+            in.readIntoMemoryBlock(text, (juce::ssize_t)juce::jmin(chunkSize, (juce::int64)256));
+            auto contents = text.toString();
+
+            if (!contents.startsWith("<!>"))
+                return 0;
+
+            return contents.substring(3).getIntValue();
+        }
+
+        /* chunks are padded to an even length. */
+        if (!in.setPosition(chunkStart + chunkSize + (chunkSize & 1)))
+            return 0;
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavetableMipmap.h"
+
+/*
+* A wavetable file, a wav or aiff of single cycle frames one after another (the layout Serum and most
+* other wavetable synths save). The file is memory mapped rather than read, so opening a bank of
+* hundreds of frames costs address space only and the system pages in just the frames that are used.
+*
+* A frame is converted the first time it is asked for, to a band limited WavetableMipmap for a carrier
+* or a window table with its guard sample, and kept for as long as the bank is. Converting reads the file
+* and allocates, so it is never done on the audio thread, SynthAudioSource leaves it to its TableBuilder.
+*/
+class MappedWavetableBank
+{
+public:
+    MappedWavetableBank();
+    ~MappedWavetableBank();
+
+    /*
+    * maps the file, nothing is read until a frame is asked for. A frameSize of 0 takes the size saved in
+    * the file by Serum (its clm chunk), or defaultFrameSize if there is none. Frames must be a power of two
+    * long for the fixed point readers, a trailing part frame is ignored and only the first channel is used.
+    */
+    juce::Result open(const juce::File& file, int frameSize = 0);
+
+    bool isOpen() const;
+    juce::File getFile() const;
+    int getNumFrames() const;
+    int getFrameSize() const;
+
+    /* the frame as a carrier, band limited per level like WavetableBank's mipmaps. frame is clamped. */
+    const WavetableMipmap& getCarrier(int frame);
+
+    /* the frame as a window, frameSize + 1 samples for Pulsar::setWindowTable. frame is clamped. */
+    const juce::AudioSampleBuffer& getWindow(int frame);
+
+    static constexpr int defaultFrameSize = 2048;
+private:
+    /* the frame size in a Serum clm chunk ("<!>2048 ..."), 0 if the file has none. */
+    static int findSerumFrameSize(const juce::File& file);
+
+    void readFrame(int frame, juce::AudioSampleBuffer& destination);
+
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+    int frameSize = 0, numFrames = 0;
+
+    /* one slot per frame, empty until the frame is converted. */
+    juce::CriticalSection lock;
+    std::vector<std::unique_ptr<WavetableMipmap>> carriers;
+    std::vector<std::unique_ptr<juce::AudioSampleBuffer>> windows;
+    juce::AudioSampleBuffer scratch;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MappedWavetableBank)
+};
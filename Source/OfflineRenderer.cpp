@@ -0,0 +1,328 @@
+#include "OfflineRenderer.h"
+
+namespace
+{
+    /* sweepable parameters, in the order they appear in renders.csv. */
+    struct SweepParameter
+    {
+        const char* name;
+        std::function<void(RenderSettings&, double)> set;
+    };
+
+    const std::vector<SweepParameter>& getSweepParameters()
+    {
+        static const std::vector<SweepParameter> parameters
+        {
+            { "fundamental",           [](RenderSettings& s, double v) { s.fundamental          = (float)v; } },
+            { "period",                [](RenderSettings& s, double v) { s.period               = (float)v; } },
+            { "spread",                [](RenderSettings& s, double v) { s.periodSpread         = (float)v; } },
+            { "formant",               [](RenderSettings& s, double v) { s.formant              = (float)v; } },
+            { "index",                 [](RenderSettings& s, double v) { s.index                = (float)v; } },
+            { "routing",               [](RenderSettings& s, double v) { s.routing              = juce::jlimit(0, 2, juce::roundToInt(v)); } },
+            { "phaseModulation",       [](RenderSettings& s, double v) { s.phaseModulation      = juce::jlimit(0, 1, juce::roundToInt(v)); } },
+            { "ratioOne",              [](RenderSettings& s, double v) { s.ratioOne             = (float)v; } },
+            { "ratioTwo",              [](RenderSettings& s, double v) { s.ratioTwo             = (float)v; } },
+            { "feedback",              [](RenderSettings& s, double v) { s.feedback             = (float)v; } },
+            { "pulsarets",             [](RenderSettings& s, double v) { s.pulsarets            = juce::roundToInt(v); } },
+            { "window",                [](RenderSettings& s, double v) { s.window               = juce::jlimit(0, WindowTables::numShapes - 1, juce::roundToInt(v)); } },
+            { "waveletInterpolation",  [](RenderSettings& s, double v) { s.waveletInterpolation = juce::jlimit(0, 3, juce::roundToInt(v)); } },
+            { "windowInterpolation",   [](RenderSettings& s, double v) { s.windowInterpolation  = juce::jlimit(0, 3, juce::roundToInt(v)); } },
+            { "masking",               [](RenderSettings& s, double v) { s.masking              = juce::roundToInt(v); } },
+            { "pattern",               [](RenderSettings& s, double v) { s.pattern              = juce::roundToInt(v); } },
+            { "patternLength",         [](RenderSettings& s, double v) { s.patternLength        = juce::roundToInt(v); } },
+            { "seed",                  [](RenderSettings& s, double v) { s.seed                 = juce::roundToInt(v); } },
+            { "oversampling",          [](RenderSettings& s, double v) { s.oversampling         = juce::jlimit(1, 8, juce::roundToInt(v)); } },
+            { "oversamplingThreshold", [](RenderSettings& s, double v) { s.oversamplingThreshold = (float)v; } },
+            { "cloudDensity",          [](RenderSettings& s, double v) { s.cloudDensity         = (float)v; } },
+            { "cloudSpread",           [](RenderSettings& s, double v) { s.cloudSpread          = (float)v; } },
+            { "cloudWidth",            [](RenderSettings& s, double v) { s.cloudWidth           = (float)v; } },
+            { "panning",               [](RenderSettings& s, double v) { s.panning              = juce::jlimit(0, 1, juce::roundToInt(v)); } },
+            { "pan",                   [](RenderSettings& s, double v) { s.pan                  = (float)v; } },
+            { "panSpread",             [](RenderSettings& s, double v) { s.panSpread            = (float)v; } },
+            { "carrier",               [](RenderSettings& s, double v) { s.carrier              = juce::jlimit(0, 3, juce::roundToInt(v)); } },
+            { "carrierFrame",          [](RenderSettings& s, double v) { s.carrierFrame         = juce::jmax(-1, juce::roundToInt(v)); } },
+            { "windowFrame",           [](RenderSettings& s, double v) { s.windowFrame          = juce::jmax(-1, juce::roundToInt(v)); } },
+            { "attack",                [](RenderSettings& s, double v) { s.attack               = (float)v; } },
+            { "decay",                 [](RenderSettings& s, double v) { s.decay                = (float)v; } },
+            { "sustain",               [](RenderSettings& s, double v) { s.sustain              = (float)v; } },
+            { "release",               [](RenderSettings& s, double v) { s.release              = (float)v; } }
+        };
+
+        return parameters;
+    }
+}
+
+OfflineRenderer::OfflineRenderer()
+{
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
+juce::Result OfflineRenderer::loadSweep(const juce::var& spec)
+{
+    renders.clearQuick();
+
+    if (!spec.isObject())
+        return juce::Result::fail("the sweep spec must be a JSON object");
+
+    RenderSettings defaults;
+    defaults.sampleRate  = spec.getProperty("sampleRate", defaults.sampleRate);
+    defaults.blockSize   = spec.getProperty("blockSize",  defaults.blockSize);
+    defaults.numChannels = spec.getProperty("channels",   defaults.numChannels);
+    defaults.bitDepth    = spec.getProperty("bitDepth",   defaults.bitDepth);
+    defaults.midiNote    = spec.getProperty("note",       defaults.midiNote);
+    defaults.noteSeconds = spec.getProperty("seconds",    defaults.noteSeconds);
+    defaults.tailSeconds = spec.getProperty("tail",       defaults.tailSeconds);
+    defaults.frameSize   = spec.getProperty("frameSize",  defaults.frameSize);
+
+    if (defaults.sampleRate <= 0.0 || defaults.blockSize <= 0 || defaults.numChannels <= 0)
+        return juce::Result::fail("sampleRate, blockSize and channels must be positive");
+
+    /* relative to the working directory. Checked here rather than failing every render. */
+    if (spec.hasProperty("wavetable"))
+    {
+        defaults.wavetable = juce::File::getCurrentWorkingDirectory().getChildFile(spec.getProperty("wavetable", {}).toString());
+
+        if (!defaults.wavetable.existsAsFile())
+            return juce::Result::fail("no such wavetable " + defaults.wavetable.getFullPathName());
+    }
+
+    renders.add(defaults);
+
+    auto parameters = spec.getProperty("parameters", juce::var());
+
+    /* expand the list of renders by every value of each parameter in turn. */
+    for (auto& parameter : getSweepParameters())
+    {
+        if (!parameters.hasProperty(parameter.name))
+            continue;
+
+        juce::Array<double> values;
+        auto result = parseValues(parameters.getProperty(parameter.name, juce::var()), values);
+
+        if (result.failed())
+            return juce::Result::fail(juce::String(parameter.name) + ": " + result.getErrorMessage());
+
+        juce::Array<RenderSettings> expanded;
+        expanded.ensureStorageAllocated(renders.size() * values.size());
+
+        for (auto& settings : renders)
+        {
+            for (auto value : values)
+            {
+                auto copy = settings;
+                parameter.set(copy, value);
+                expanded.add(copy);
+            }
+        }
+
+        renders.swapWith(expanded);
+    }
+
+    return juce::Result::ok();
+}
+
+const juce::Array<RenderSettings>& OfflineRenderer::getRenders() const
+{
+    return renders;
+}
+
+juce::Result OfflineRenderer::parseValues(const juce::var& value, juce::Array<double>& values)
+{
+    if (value.isArray())
+    {
+        for (auto& v : *value.getArray())
+            values.add((double)v);
+    }
+    else if (value.isObject())
+    {
+        double from = value.getProperty("from", 0.0);
+        double to   = value.getProperty("to", from);
+        int steps   = value.getProperty("steps", 1);
+
+        if (steps < 1)
+            return juce::Result::fail("steps must be at least 1");
+
+        for (int i = 0; i < steps; ++i)
+            values.add(steps == 1 ? from : from + (to - from) * (double)i / (double)(steps - 1));
+    }
+    else
+    {
+        values.add((double)value);
+    }
+
+    if (values.isEmpty())
+        return juce::Result::fail("no values given");
+
+    return juce::Result::ok();
+}
+
+juce::String OfflineRenderer::getFileName(int renderIndex)
+{
+    return "pulsar_" + juce::String(renderIndex).paddedLeft('0', 5) + ".wav";
+}
+
+juce::Result OfflineRenderer::renderAll(const juce::File& outputDirectory, int numThreads)
+{
+    auto created = outputDirectory.createDirectory();
+
+    if (created.failed())
+        return created;
+
+    /* renders.csv, one line per file so the batch can be searched afterwards. */
+    juce::String manifest("file");
+
+    for (auto& parameter : getSweepParameters())
+        manifest << "," << parameter.name;
+
+    manifest << "\n";
+
+    for (int i = 0; i < renders.size(); ++i)
+    {
+        auto& s = renders.getReference(i);
+        manifest << getFileName(i) << "," << s.fundamental << "," << s.period << "," << s.periodSpread
+                 << "," << s.formant << "," << s.index << "," << s.routing << "," << s.phaseModulation
+                 << "," << s.ratioOne << "," << s.ratioTwo << "," << s.feedback << "," << s.pulsarets << "," << s.window
+                 << "," << s.waveletInterpolation << "," << s.windowInterpolation << "," << s.masking << "," << s.pattern
+                 << "," << s.patternLength << "," << s.seed << "," << s.oversampling << "," << s.oversamplingThreshold
+                 << "," << s.cloudDensity << "," << s.cloudSpread << "," << s.cloudWidth
+                 << "," << s.panning << "," << s.pan << "," << s.panSpread
+                 << "," << s.carrier << "," << s.carrierFrame << "," << s.windowFrame << "," << s.attack
+                 << "," << s.decay << "," << s.sustain << "," << s.release << "\n";
+    }
+
+    if (!outputDirectory.getChildFile("renders.csv").replaceWithText(manifest))
+        return juce::Result::fail("could not write renders.csv");
+
+    /* each render owns its own SynthAudioSource, so they are completely independent. */
+    juce::ThreadPool pool(juce::jmax(1, numThreads));
+    juce::CriticalSection errorLock;
+    juce::StringArray errors;
+
+    for (int i = 0; i < renders.size(); ++i)
+    {
+        pool.addJob([this, i, outputDirectory, &errorLock, &errors]
+        {
+            auto result = render(renders.getReference(i), outputDirectory.getChildFile(getFileName(i)));
+
+            if (result.failed())
+            {
+                const juce::ScopedLock sl(errorLock);
+                errors.add(getFileName(i) + ": " + result.getErrorMessage());
+            }
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(10);
+
+    if (!errors.isEmpty())
+        return juce::Result::fail(errors.joinIntoString("\n"));
+
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::render(const RenderSettings& settings, const juce::File& outputFile)
+{
+    juce::MidiKeyboardState keyboardState;
+    SynthAudioSource source(keyboardState);
+
+    /* the renders already run one per core, a voice pool per render would only fight over them. */
+    source.setNumRenderThreads(0);
+
+    /* faster than real time, so every change lands at the start of the next block. */
+    source.setRealtime(false);
+
+    source.setNumOutputChannels(settings.numChannels);
+    source.prepareToPlay(settings.blockSize, settings.sampleRate);
+    source.amplitudeEnvelope (settings.attack, settings.decay, settings.sustain, settings.release);
+    source.setKeyboardControl(false);
+    source.setFundamental    (settings.fundamental);
+    source.setPeriod         (settings.period);
+    source.setPeriodSpread   (settings.periodSpread);
+    source.setFormant        (settings.formant);
+    source.setIndex          (settings.index);
+    source.setModulation     ((Pulsar::Routing)settings.routing, settings.phaseModulation != 0);
+    source.setModulatorRatios(settings.ratioOne, settings.ratioTwo);
+    source.setFeedback       (settings.feedback);
+    source.setNumPulsarets   (settings.pulsarets);
+    source.setWindowShape    ((WindowTables::Shape)settings.window);
+    source.setInterpolation  ((Wavetable::Interpolation)settings.waveletInterpolation,
+                              (Wavetable::Interpolation)settings.windowInterpolation);
+    source.setMasking        (settings.masking);
+    source.setMaskingPattern ((juce::uint32)settings.pattern, settings.patternLength);
+    source.setMaskingSeed    (settings.seed);
+    source.setOversampling   (settings.oversampling, settings.oversamplingThreshold);
+    source.setCloud          (settings.cloudDensity, settings.cloudSpread, settings.cloudWidth);
+    source.setPanning        (settings.panning != 0, settings.pan, settings.panSpread);
+
+    /* every render maps the file for itself, the system shares the pages between them. */
+    if (settings.wavetable != juce::File())
+    {
+        auto loaded = source.loadWavetableBank(settings.wavetable, settings.frameSize);
+
+        if (loaded.failed())
+            return loaded;
+
+        source.setWavetableFrames(settings.carrierFrame, settings.windowFrame);
+    }
+
+    if (settings.carrier != 0)
+    {
+        static const WavetableBank::Shape carriers[] { WavetableBank::Shape::sine, WavetableBank::Shape::saw,
+                                                       WavetableBank::Shape::square, WavetableBank::Shape::triangle };
+
+        source.setCarrierHarmonics(WavetableBank::getHarmonics(carriers[settings.carrier], WavetableBank::defaultTableSize / 2));
+    }
+
+    /* the tables are built in the background, the note should start with them. */
+    if (!source.waitForTables())
+        return juce::Result::fail("timed out building the tables");
+
+    outputFile.deleteFile();
+
+    std::unique_ptr<juce::FileOutputStream> stream(outputFile.createOutputStream());
+
+    if (stream == nullptr)
+        return juce::Result::fail("could not open " + outputFile.getFullPathName());
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), settings.sampleRate,
+                                                                              (unsigned int)settings.numChannels,
+                                                                              settings.bitDepth, {}, 0));
+
+    if (writer == nullptr)
+        return juce::Result::fail("could not create a wav writer");
+
+    /* the writer owns the stream now. */
+    stream.release();
+
+    /* the oversampling delay is rendered and dropped from the start, so the file lines up with the note. */
+    auto latency      = source.getLatencySamples();
+    auto noteSamples  = (juce::int64)(settings.noteSeconds * settings.sampleRate);
+    auto totalSamples = noteSamples + (juce::int64)(settings.tailSeconds * settings.sampleRate) + latency;
+
+    juce::AudioSampleBuffer buffer(settings.numChannels, settings.blockSize);
+    keyboardState.noteOn(1, settings.midiNote, 1.0f);
+
+    for (juce::int64 position = 0; position < totalSamples; position += settings.blockSize)
+    {
+        if (position >= noteSamples && keyboardState.isNoteOn(1, settings.midiNote))
+            keyboardState.noteOff(1, settings.midiNote, 0.0f);
+
+        auto numSamples = (int)juce::jmin((juce::int64)settings.blockSize, totalSamples - position);
+
+        juce::AudioSourceChannelInfo info(&buffer, 0, numSamples);
+        source.getNextAudioBlock(info);
+
+        auto numToSkip = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, latency - position);
+
+        if (!writer->writeFromAudioSampleBuffer(buffer, numToSkip, numSamples - numToSkip))
+            return juce::Result::fail("could not write to " + outputFile.getFullPathName());
+    }
+
+    source.releaseResources();
+    return juce::Result::ok();
+}
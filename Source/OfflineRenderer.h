@@ -0,0 +1,97 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SynthAudioSource.h"
+
+/* everything needed to render one note of a SynthAudioSource to a file. */
+struct RenderSettings
+{
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int numChannels = 2;
+    int bitDepth = 24;
+
+    /* the note is held for noteSeconds, then released and rendered for another tailSeconds. */
+    int midiNote = 60;
+    double noteSeconds = 4.0;
+    double tailSeconds = 1.0;
+
+    float fundamental = 220.0f;
+    float period = 1.0f, periodSpread = 1.0f;
+    float formant = 1.0f;
+    float index = 0.0f;
+
+    /* Pulsar::Routing as a number, 0 parallel, 1 serial, 2 feedback. phaseModulation is 0 or 1. */
+    int routing = 0, phaseModulation = 0;
+    float ratioOne = 1.0f, ratioTwo = 6.0f;
+    float feedback = 0.0f;
+    int pulsarets = 3;
+
+    /* WindowTables::Shape as a number, 0 hann, 1 gaussian, 2 tukey, 3 expodec, 4 rexpodec, 5 trapezoid, 6 sinc. */
+    int window = 0;
+
+    /* Wavetable::Interpolation as a number, 0 none, 1 linear, 2 hermite, 3 lagrange. */
+    int waveletInterpolation = 1, windowInterpolation = 1;
+    int masking = 0;
+
+    /* pattern masking when patternLength is above 0, the seed makes random masking repeatable. */
+    int pattern = 0, patternLength = 0;
+    int seed = 1;
+
+    /* largest oversampling factor, 1 is off, and the fraction of the oversampled rate that triggers it. */
+    int oversampling = 1;
+    float oversamplingThreshold = 0.45f;
+
+    /* grains per second, 0 is the pulse train, the formant spread in octaves and the stereo width, see PulsaretCloud. */
+    float cloudDensity = 0.0f, cloudSpread = 0.0f, cloudWidth = 0.0f;
+
+    /* panning is 0 or 1, pan and panSpread place the pulsarets over the channels, see PanMatrix. */
+    int panning = 0;
+    float pan = 0.5f, panSpread = 0.0f;
+
+    /*
+    * a wavetable file to take the carriers and window from, see MappedWavetableBank. A frameSize of 0
+    * reads it from the file, a frame of -1 keeps the built in sine carrier or window.
+    */
+    juce::File wavetable;
+    int frameSize = 0;
+    int carrierFrame = -1, windowFrame = -1;
+
+    /* the carrier waveform when there is no carrier frame, 0 sine, 1 saw, 2 square, 3 triangle. */
+    int carrier = 0;
+    float attack = 0.5f, decay = 0.5f, sustain = 0.5f, release = 0.5f;
+};
+
+/*
+* Renders pulsar notes to wav files without an audio device, as fast as the cpu allows.
+* A sweep spec is a JSON object, each parameter may be a single value, a list of values
+* or a range { "from": 1, "to": 12, "steps": 4 }. Every combination is rendered.
+*
+* {
+*     "sampleRate": 48000, "seconds": 4, "tail": 1, "note": 60,
+*     "parameters": { "fundamental": [ 50, 100, 200 ], "formant": { "from": 0.1, "to": 1, "steps": 10 } }
+* }
+*/
+class OfflineRenderer
+{
+public:
+    OfflineRenderer();
+    ~OfflineRenderer();
+
+    /* builds the list of renders from a sweep spec, returns an error if the spec is malformed. */
+    juce::Result loadSweep(const juce::var& spec);
+    const juce::Array<RenderSettings>& getRenders() const;
+
+    /*
+    * renders every setting into outputDirectory on numThreads threads, one render per thread at a time.
+    * writes renders.csv alongside the wav files listing the parameters of each file.
+    */
+    juce::Result renderAll(const juce::File& outputDirectory, int numThreads);
+
+    static juce::Result render(const RenderSettings& settings, const juce::File& outputFile);
+private:
+    static juce::Result parseValues(const juce::var& value, juce::Array<double>& values);
+    static juce::String getFileName(int renderIndex);
+
+    juce::Array<RenderSettings> renders;
+};
@@ -0,0 +1,90 @@
+#include "PanMatrix.h"
+
+PanMatrix::PanMatrix()
+{
+}
+
+PanMatrix::~PanMatrix()
+{
+}
+
+void PanMatrix::update(int newNumChannels, int newNumRows, bool shouldPan, float newCentre, float newSpread)
+{
+    newNumRows = juce::jlimit(1, maxRows, newNumRows);
+
+    if (newNumChannels == numChannels && newNumRows == numRows && shouldPan == panning
+        && newCentre == centre && newSpread == spread)
+        return;
+
+    numChannels = newNumChannels;
+    numRows = newNumRows;
+    panning = shouldPan;
+    centre = newCentre;
+    spread = newSpread;
+
+    centreRow = getRow(centre);
+
+    for (int i = 0; i < numRows; ++i)
+        rows[(size_t)i] = getRow(centre + spread * (((float)i + 0.5f) / (float)numRows - 0.5f));
+}
+
+bool PanMatrix::isUniform() const
+{
+    return !panning || spread == 0.0f || numRows == 1;
+}
+
+void PanMatrix::addRow(int row, const float* input, float* const* outputs, int numSamples) const
+{
+    addWithGains(rows[(size_t)row], input, outputs, numSamples);
+}
+
+void PanMatrix::addCentre(const float* input, float* const* outputs, int numSamples) const
+{
+    addWithGains(centreRow, input, outputs, numSamples);
+}
+
+void PanMatrix::addWithGains(const Row& row, const float* input, float* const* outputs, int numSamples) const
+{
+    if (!panning)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::add(outputs[channel], input, numSamples);
+
+        return;
+    }
+
+    juce::FloatVectorOperations::addWithMultiply(outputs[row.channelOne], input, row.gainOne, numSamples);
+
+    if (row.gainTwo != 0.0f)
+        juce::FloatVectorOperations::addWithMultiply(outputs[row.channelTwo], input, row.gainTwo, numSamples);
+}
+
+/* the two channels either side of position and their constant power gains. */
+PanMatrix::Row PanMatrix::getRow(float position) const
+{
+    Row row;
+
+    if (numChannels < 2)
+        return row;
+
+    float between;
+
+    if (numChannels == 2)
+    {
+        between = juce::jlimit(0.0f, 1.0f, position);
+        row.channelTwo = 1;
+    }
+    else
+    {
+        auto place = (position - std::floor(position)) * (float)numChannels;
+        auto speaker = juce::jmin((int)place, numChannels - 1);
+
+        between = place - (float)speaker;
+        row.channelOne = speaker;
+        row.channelTwo = (speaker + 1) % numChannels;
+    }
+
+    row.gainOne = std::cos(between * juce::MathConstants<float>::halfPi);
+    row.gainTwo = std::sin(between * juce::MathConstants<float>::halfPi);
+    return row;
+}
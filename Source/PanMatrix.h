@@ -0,0 +1,52 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+* The gain matrix from a voice's pulsarets to the output channels.
+*
+* With panning off every channel gets the whole voice, as before there was a matrix.
+* With it on each pulsaret has a position from 0 to 1. Two channels are a line from left to right,
+* three or more a ring of equally spaced speakers, once round from channel 0 back to it.
+* A pulsaret sounds from the two speakers either side of its position with a constant power law
+* (pairwise panning), so each row of the matrix has at most two gains and is kept as just those.
+* Mixing a pulsaret costs two vector adds however many channels there are.
+*/
+class PanMatrix
+{
+public:
+    PanMatrix();
+    ~PanMatrix();
+
+    static constexpr int maxRows = 64, maxChannels = 64;
+
+    /*
+    * works the matrix out again, only if something has changed. Row i is pulsaret i of numRows,
+    * at centre + spread * ((i + 0.5) / numRows - 0.5), a spread of 1 spaces them across the whole line or ring.
+    */
+    void update(int numChannels, int numRows, bool panning, float centre, float spread);
+
+    /* true when every row has the same gains, the voice is then mixed once rather than per pulsaret. */
+    bool isUniform() const;
+
+    /* adds input to the outputs with row's gains, outputs has a pointer for every channel. */
+    void addRow(int row, const float* input, float* const* outputs, int numSamples) const;
+
+    /* the same at the centre position, for the whole voice when its pulsarets cannot be rendered apart. */
+    void addCentre(const float* input, float* const* outputs, int numSamples) const;
+private:
+    struct Row
+    {
+        int channelOne = 0, channelTwo = 0;
+        float gainOne = 1.0f, gainTwo = 0.0f;
+    };
+
+    Row getRow(float position) const;
+    void addWithGains(const Row& row, const float* input, float* const* outputs, int numSamples) const;
+
+    std::array<Row, maxRows> rows;
+    Row centreRow;
+    int numChannels = 0, numRows = 0;
+    bool panning = false;
+    float centre = -1.0f, spread = -1.0f;
+};
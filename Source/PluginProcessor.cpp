@@ -0,0 +1,289 @@
+#include "PluginProcessor.h"
+
+PulsarAudioProcessor::PulsarAudioProcessor()
+    : juce::AudioProcessor(BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true)),
+    state(*this, nullptr, "PulsarParameters", createParameterLayout())
+{
+    fundamental          = state.getRawParameterValue("fundamental");
+    keyboardControl      = state.getRawParameterValue("keyboardControl");
+    period               = state.getRawParameterValue("period");
+    periodSpread         = state.getRawParameterValue("periodSpread");
+    formant              = state.getRawParameterValue("formant");
+    index                = state.getRawParameterValue("index");
+    routing              = state.getRawParameterValue("routing");
+    phaseModulation      = state.getRawParameterValue("phaseModulation");
+    ratioOne             = state.getRawParameterValue("ratioOne");
+    ratioTwo             = state.getRawParameterValue("ratioTwo");
+    feedback             = state.getRawParameterValue("feedback");
+    numPulsarets         = state.getRawParameterValue("pulsarets");
+    windowShape          = state.getRawParameterValue("window");
+    waveletInterpolation = state.getRawParameterValue("waveletInterpolation");
+    windowInterpolation  = state.getRawParameterValue("windowInterpolation");
+    masking              = state.getRawParameterValue("masking");
+    oversampling         = state.getRawParameterValue("oversampling");
+    cloudDensity         = state.getRawParameterValue("cloudDensity");
+    cloudSpread          = state.getRawParameterValue("cloudSpread");
+    cloudWidth           = state.getRawParameterValue("cloudWidth");
+    panning              = state.getRawParameterValue("panning");
+    pan                  = state.getRawParameterValue("pan");
+    panSpread            = state.getRawParameterValue("panSpread");
+    attack               = state.getRawParameterValue("attack");
+    decay                = state.getRawParameterValue("decay");
+    sustain              = state.getRawParameterValue("sustain");
+    release              = state.getRawParameterValue("release");
+    bypass = dynamic_cast<juce::AudioParameterBool*>(state.getParameter("bypass"));
+
+    /* the host runs instances in parallel already, a render pool per instance would only fight it. */
+    source.setNumRenderThreads(0);
+    source.setNumVoices(numVoices);
+
+    startTimerHz(10);
+}
+
+PulsarAudioProcessor::~PulsarAudioProcessor()
+{
+    stopTimer();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout PulsarAudioProcessor::createParameterLayout()
+{
+    using Range = juce::NormalisableRange<float>;
+
+    juce::StringArray interpolations { "None", "Linear", "Hermite", "Lagrange" };
+
+    /* the ranges are the standalone app's sliders. */
+    Range fundamentalRange(1.0f, 400.0f);
+    fundamentalRange.setSkewForCentre(50.0f);
+
+    Range formantRange(0.01f, 1.0f);
+    formantRange.skew = 0.4f;
+
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    layout.add(std::make_unique<juce::AudioParameterFloat>("fundamental", "Fundamental", fundamentalRange, 220.0f));
+    layout.add(std::make_unique<juce::AudioParameterBool>("keyboardControl", "Keyboard", true));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("period", "Period", Range(1.0f, 12.0f), 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("periodSpread", "Period Spread", Range(1.0f, 2.0f), 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("formant", "Formant", formantRange, 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("index", "Index", Range(0.0f, 1.0f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("routing", "Routing",
+                                                            juce::StringArray { "Parallel", "Serial", "Feedback" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>("phaseModulation", "Phase Modulation", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("ratioOne", "Ratio One", Range(0.25f, 16.0f, 0.0f, 0.5f), 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("ratioTwo", "Ratio Two", Range(0.25f, 16.0f, 0.0f, 0.5f), 6.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("feedback", "Feedback", Range(0.0f, 1.0f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterInt>("pulsarets", "Pulsarets", 1, Pulsar::maxWavelets, 3));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("window", "Window",
+                                                            juce::StringArray { "Hann", "Gaussian", "Tukey", "Expodec",
+                                                                                "Rexpodec", "Trapezoid", "Sinc" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("waveletInterpolation", "Wavelet Interpolation", interpolations, 1));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("windowInterpolation", "Window Interpolation", interpolations, 1));
+    layout.add(std::make_unique<juce::AudioParameterInt>("masking", "Masking", 0, 100, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("oversampling", "Oversampling",
+                                                            juce::StringArray { "Off", "2x", "4x", "8x" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("cloudDensity", "Cloud Density", Range(0.0f, 20000.0f, 0.0f, 0.3f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("cloudSpread", "Cloud Spread", Range(0.0f, 3.0f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("cloudWidth", "Cloud Width", Range(0.0f, 1.0f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterBool>("panning", "Panning", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("pan", "Pan", Range(0.0f, 1.0f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("panSpread", "Pan Spread", Range(0.0f, 1.0f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("attack", "Attack", Range(0.0f, 1.0f, 0.001f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("decay", "Decay", Range(0.0f, 1.0f, 0.001f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("sustain", "Sustain", Range(0.0f, 1.0f, 0.001f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("release", "Release", Range(0.0f, 1.0f, 0.001f), 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterBool>("bypass", "Bypass", false));
+
+    return layout;
+}
+
+PulsarParameters PulsarAudioProcessor::readParameters() const
+{
+    PulsarParameters parameters;
+    parameters.fundamental          = fundamental->load();
+    parameters.keyboardControl      = keyboardControl->load() > 0.5f;
+    parameters.period               = period->load();
+    parameters.periodSpread         = periodSpread->load();
+    parameters.formant              = formant->load();
+    parameters.index                = index->load();
+    parameters.routing              = (Pulsar::Routing)juce::roundToInt(routing->load());
+    parameters.phaseModulation      = phaseModulation->load() > 0.5f;
+    parameters.ratioOne             = ratioOne->load();
+    parameters.ratioTwo             = ratioTwo->load();
+    parameters.feedback             = feedback->load();
+    parameters.numPulsarets         = juce::roundToInt(numPulsarets->load());
+    parameters.windowShape          = (WindowTables::Shape)juce::roundToInt(windowShape->load());
+    parameters.waveletInterpolation = (Wavetable::Interpolation)juce::roundToInt(waveletInterpolation->load());
+    parameters.windowInterpolation  = (Wavetable::Interpolation)juce::roundToInt(windowInterpolation->load());
+    parameters.masking              = juce::roundToInt(masking->load());
+    parameters.oversampling         = 1 << juce::roundToInt(oversampling->load());
+    parameters.cloudDensity         = cloudDensity->load();
+    parameters.cloudSpread          = cloudSpread->load();
+    parameters.cloudWidth           = cloudWidth->load();
+    parameters.panning              = panning->load() > 0.5f;
+    parameters.pan                  = pan->load();
+    parameters.panSpread            = panSpread->load();
+    parameters.attack               = attack->load();
+    parameters.decay                = decay->load();
+    parameters.sustain              = sustain->load();
+    parameters.release              = release->load();
+    return parameters;
+}
+
+void PulsarAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    maxBlockSize = juce::jmax(1, samplesPerBlock);
+
+    source.setRealtime(!isNonRealtime());
+    source.setNumOutputChannels(getTotalNumOutputChannels());
+    source.prepareToPlay(maxBlockSize, sampleRate);
+    source.applyParameters(readParameters());
+    setLatencySamples(SynthAudioSource::getLatencySamples(readParameters()));
+}
+
+void PulsarAudioProcessor::releaseResources()
+{
+    source.releaseResources();
+}
+
+bool PulsarAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+    /*
+    * mono, stereo or a speaker array. With panning on the channels are taken in order as a ring of speakers,
+    * see PanMatrix, a cloud only plays in the first two.
+    */
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+    return numChannels >= 1 && numChannels <= 16;
+}
+
+/*
+* hosts may pass fewer samples than promised, or more, so the block is rendered in pieces
+* no longer than the size the voices were prepared for.
+*/
+void PulsarAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (bypass->get())
+    {
+        processBlockBypassed(buffer, midiMessages);
+        return;
+    }
+
+    juce::ScopedNoDenormals noDenormals;
+    const RealtimeCheck::ScopedSection realtime;
+    bypassed = false;
+    buffer.clear();
+    source.applyParameters(readParameters());
+
+    auto numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+        source.renderNextBlock(buffer, midiMessages, start, juce::jmin(maxBlockSize, numSamples - start));
+}
+
+/* silent while bypassed. The notes are cut on the way in so none are left hanging on the way out. */
+void PulsarAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    buffer.clear();
+
+    if (!bypassed)
+    {
+        source.allNotesOff();
+        bypassed = true;
+    }
+}
+
+void PulsarAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    juce::AudioProcessor::setNonRealtime(isNonRealtime);
+    source.setRealtime(!isNonRealtime);
+}
+
+void PulsarAudioProcessor::timerCallback()
+{
+    auto latency = SynthAudioSource::getLatencySamples(readParameters());
+
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
+juce::AudioProcessorEditor* PulsarAudioProcessor::createEditor()
+{
+    return new juce::GenericAudioProcessorEditor(*this);
+}
+
+bool PulsarAudioProcessor::hasEditor() const
+{
+    return true;
+}
+
+const juce::String PulsarAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool PulsarAudioProcessor::acceptsMidi() const
+{
+    return true;
+}
+
+bool PulsarAudioProcessor::producesMidi() const
+{
+    return false;
+}
+
+bool PulsarAudioProcessor::isMidiEffect() const
+{
+    return false;
+}
+
+double PulsarAudioProcessor::getTailLengthSeconds() const
+{
+    /* the longest release. */
+    return 1.0;
+}
+
+int PulsarAudioProcessor::getNumPrograms()
+{
+    return 1;
+}
+
+int PulsarAudioProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+void PulsarAudioProcessor::setCurrentProgram(int)
+{
+}
+
+const juce::String PulsarAudioProcessor::getProgramName(int)
+{
+    return {};
+}
+
+void PulsarAudioProcessor::changeProgramName(int, const juce::String&)
+{
+}
+
+void PulsarAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    if (auto xml = state.copyState().createXml())
+        copyXmlToBinary(*xml, destData);
+}
+
+void PulsarAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    auto xml = getXmlFromBinary(data, sizeInBytes);
+
+    if (xml != nullptr && xml->hasTagName(state.state.getType()))
+        state.replaceState(juce::ValueTree::fromXml(*xml));
+}
+
+juce::AudioProcessorParameter* PulsarAudioProcessor::getBypassParameter() const
+{
+    return bypass;
+}
+
+//==============================================================================
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new PulsarAudioProcessor();
+}
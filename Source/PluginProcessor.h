@@ -0,0 +1,100 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SynthAudioSource.h"
+
+/*
+* Pulsar as a VST3/LV2 instrument, a SynthAudioSource driven by the host's midi and automation.
+* Everything is allocated in prepareToPlay, processBlock only reads the parameters and renders,
+* on the host's thread, so many instances can share the host's graph without a thread pool each.
+*/
+class PulsarAudioProcessor : public juce::AudioProcessor,
+    private juce::Timer
+{
+public:
+    PulsarAudioProcessor();
+    ~PulsarAudioProcessor() override;
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    void processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+    using juce::AudioProcessor::processBlock;
+    using juce::AudioProcessor::processBlockBypassed;
+
+    /* offline, queued changes land on block boundaries so bounces repeat exactly. */
+    void setNonRealtime(bool isNonRealtime) noexcept override;
+
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    const juce::String getName() const override;
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram(int index) override;
+    const juce::String getProgramName(int index) override;
+    void changeProgramName(int index, const juce::String& newName) override;
+
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    juce::AudioProcessorParameter* getBypassParameter() const override;
+private:
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    /* a snapshot of every parameter, the values are atomics so any thread may call this. */
+    PulsarParameters readParameters() const;
+
+    /*
+    * the oversampling parameter changes the latency. The host is told from the message thread,
+    * telling it from processBlock could allocate.
+    */
+    void timerCallback() override;
+
+    juce::MidiKeyboardState keyboardState;
+    SynthAudioSource source { keyboardState };
+    juce::AudioProcessorValueTreeState state;
+
+    /* looked up once, processBlock never searches for a parameter by name. */
+    std::atomic<float>* fundamental = nullptr;
+    std::atomic<float>* keyboardControl = nullptr;
+    std::atomic<float>* period = nullptr;
+    std::atomic<float>* periodSpread = nullptr;
+    std::atomic<float>* formant = nullptr;
+    std::atomic<float>* index = nullptr;
+    std::atomic<float>* routing = nullptr;
+    std::atomic<float>* phaseModulation = nullptr;
+    std::atomic<float>* ratioOne = nullptr;
+    std::atomic<float>* ratioTwo = nullptr;
+    std::atomic<float>* feedback = nullptr;
+    std::atomic<float>* numPulsarets = nullptr;
+    std::atomic<float>* windowShape = nullptr;
+    std::atomic<float>* waveletInterpolation = nullptr;
+    std::atomic<float>* windowInterpolation = nullptr;
+    std::atomic<float>* masking = nullptr;
+    std::atomic<float>* oversampling = nullptr;
+    std::atomic<float>* cloudDensity = nullptr;
+    std::atomic<float>* cloudSpread = nullptr;
+    std::atomic<float>* cloudWidth = nullptr;
+    std::atomic<float>* panning = nullptr;
+    std::atomic<float>* pan = nullptr;
+    std::atomic<float>* panSpread = nullptr;
+    std::atomic<float>* attack = nullptr;
+    std::atomic<float>* decay = nullptr;
+    std::atomic<float>* sustain = nullptr;
+    std::atomic<float>* release = nullptr;
+    juce::AudioParameterBool* bypass = nullptr;
+
+    static constexpr int numVoices = 8;
+    int maxBlockSize = 512;
+    bool bypassed = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PulsarAudioProcessor)
+};
@@ -5,7 +5,7 @@
     Created: 13 May 2022 10:20:18am
     Author:  bwhat
 
-    Simple Pulsar implementation with a hann window and parallel frequency modulated wavelet.
+    Simple Pulsar implementation with a choice of window and parallel frequency modulated wavelet.
 
   ==============================================================================
 */
@@ -13,32 +13,40 @@
 #include "Pulsar.h"
 
 /*
-* Fill each array with the window and waveform table to use create each pulsaret.
+* Fill the array with the waveform table to use create each pulsaret, all maxWavelets of them.
 * Using a juce::OwnedArray takes care of deleting each Wavetable pointer for me.
 */
 
-Pulsar::Pulsar(const juce::AudioSampleBuffer& waveTableToUse, const juce::AudioSampleBuffer& windowTableToUse)
+Pulsar::Pulsar(const WavetableMipmap& waveTableToUse, const juce::AudioSampleBuffer& windowTableToUse, int numWaveletsToUse)
+    : window(windowTableToUse),
+    modulatorOne(waveTableToUse),
+    modulatorTwo(waveTableToUse),
+    waveletTable(&waveTableToUse)
 {
-    for (int i = 0; i < numWavelets; ++i)
-    {
-        auto* window       = new Wavetable (windowTableToUse);
-        auto* wavelet      = new Wavetable (waveTableToUse);
-        auto* modulatorOne = new Wavetable (waveTableToUse);
-        auto* modulatorTwo = new Wavetable (waveTableToUse);
+    for (int i = 0; i < maxWavelets; ++i)
+        wavelets.add(new Wavetable (waveTableToUse));
 
-        wavelets.add      (wavelet);
-        windows.add       (window);
-        modulatorsOne.add (modulatorOne);
-        modulatorsTwo.add (modulatorTwo);
+    setNumWavelets(numWaveletsToUse);
+    window.setPeriodic(false);
 
-        /* initialise float vectors. */
-        _formants           .push_back(0.0f);
-        waveletPhasors      .push_back(0.0f);
-        windowPhasors       .push_back(0.0f);
-        modulatorOnePhasors .push_back(0.0f);
-        modulatorTwoPhasors .push_back(0.0f);
-        carrierPhasors      .push_back(0.0f);
-    }
+    /* a formant of zero would give an infinite window increment. */
+    formantSmooth.setCurrentAndTargetValue(1.0f);
+}
+
+Pulsar::Pulsar(const WavetableMipmap& waveTableToUse, WindowTables::Shape windowShape, int numWaveletsToUse)
+    : window(WindowTables::getTable(windowShape), WindowTables::tableSize),
+    modulatorOne(waveTableToUse),
+    modulatorTwo(waveTableToUse),
+    waveletTable(&waveTableToUse),
+    windowPhaseLimit((float)(WindowTables::tableSize - 1) / (float)WindowTables::tableSize),
+    windowEndsSilent(true)
+{
+    for (int i = 0; i < maxWavelets; ++i)
+        wavelets.add(new Wavetable (waveTableToUse));
+
+    setNumWavelets(numWaveletsToUse);
+    window.setPeriodic(false);
+    formantSmooth.setCurrentAndTargetValue(1.0f);
 }
 
 /* destructor */
@@ -49,119 +57,823 @@ Pulsar::~Pulsar()
 /*
 * access functions, set Pulsar member variables or synthesis parameters.
 */
-void Pulsar::setFundamental(float fundamental)
+void Pulsar::setSmoothTarget(Smooth& smooth, float target, bool shouldGlide)
+{
+    if (shouldGlide)
+        smooth.setTargetValue(target);
+    else
+        smooth.setCurrentAndTargetValue(target);
+}
+
+void Pulsar::setFundamental(float fundamental, bool shouldGlide)
+{
+    setSmoothTarget(fundamentalSmooth, fundamental, shouldGlide);
+}
+
+void Pulsar::setPeriod(float period, float spread, bool shouldGlide)
+{
+    setSmoothTarget(periodSmooth, period, shouldGlide);
+    setSmoothTarget(periodSpreadSmooth, spread, shouldGlide);
+}
+
+void Pulsar::setFormant(float formant, bool shouldGlide)
+{
+    setSmoothTarget(formantSmooth, formant, shouldGlide);
+}
+
+void Pulsar::setIndex(float index, bool shouldGlide)
+{
+    setSmoothTarget(indexSmooth, index, shouldGlide);
+}
+
+void Pulsar::setStochasticMasking(int maskingPercentage)
+{
+    pulseMask.setMaskingPercentage(maskingPercentage);
+}
+
+void Pulsar::setMaskingPattern(juce::uint32 pattern, int length)
 {
-    _fundamental = fundamental;
+    pulseMask.setPattern(pattern, length);
 }
 
-void Pulsar::setPeriod(float period, float spread)
+void Pulsar::setMaskingSeed(juce::uint64 seed)
 {
-    _period = period;
-    _periodSpread = spread;
+    pulseMask.setSeed(seed);
 }
 
-void Pulsar::setFormant(float formant)
+void Pulsar::setMipmapCrossfade(bool shouldCrossfade)
 {
+    for (auto* wavelet : wavelets)
+        wavelet->setCrossfade(shouldCrossfade);
+
+    modulatorOne.setCrossfade(shouldCrossfade);
+    modulatorTwo.setCrossfade(shouldCrossfade);
+}
+
+void Pulsar::setWaveletInterpolation(Wavetable::Interpolation newInterpolation)
+{
+    for (auto* wavelet : wavelets)
+        wavelet->setInterpolation(newInterpolation);
+
+    modulatorOne.setInterpolation(newInterpolation);
+    modulatorTwo.setInterpolation(newInterpolation);
+}
+
+void Pulsar::setWindowInterpolation(Wavetable::Interpolation newInterpolation)
+{
+    window.setInterpolation(newInterpolation);
+}
+
+void Pulsar::setWindowShape(WindowTables::Shape newShape)
+{
+    window.setTable(WindowTables::getTable(newShape), WindowTables::tableSize);
+    windowPhaseLimit = (float)(WindowTables::tableSize - 1) / (float)WindowTables::tableSize;
+    windowEndsSilent = true;
+}
+
+/* held on the frame's last sample like a WindowTables table, rather than at 1, which wraps round to its first. */
+void Pulsar::setWindowTable(const juce::AudioSampleBuffer& windowTableToUse)
+{
+    auto frameSize = windowTableToUse.getNumSamples() - 1;
+
+    window.setTable(windowTableToUse.getReadPointer(0), frameSize);
+    windowPhaseLimit = (float)(frameSize - 1) / (float)frameSize;
+    windowEndsSilent = (windowTableToUse.getSample(0, frameSize - 1) == 0.0f);
+}
+
+void Pulsar::setWaveletTable(const WavetableMipmap& waveTableToUse, juce::uint32 tableGeneration)
+{
+    if (&waveTableToUse == waveletTable && tableGeneration == waveletTableGeneration)
+        return;
+
+    waveletTable = &waveTableToUse;
+    waveletTableGeneration = tableGeneration;
+
+    for (auto* wavelet : wavelets)
+        wavelet->setMipmap(waveTableToUse);
+}
+
+void Pulsar::setSkipSilence(bool shouldSkip)
+{
+    skipSilence = shouldSkip;
+}
+
+void Pulsar::setModulation(Routing newRouting, Modulation newModulation)
+{
+    routing = newRouting;
+    modulation = newModulation;
+    modulatorKernel = getModulatorKernel(routing, modulation);
+}
+
+void Pulsar::setModulatorRatios(float newRatioOne, float newRatioTwo)
+{
+    ratioOne = newRatioOne;
+    ratioTwo = newRatioTwo;
+}
+
+void Pulsar::setFeedback(float newFeedback)
+{
+    feedback = newFeedback;
+}
+
+Pulsar::ModulatorKernel Pulsar::getModulatorKernel(Routing routingToUse, Modulation modulationToUse)
+{
+    if (modulationToUse == Modulation::phase)
+    {
+        switch (routingToUse)
+        {
+            case Routing::parallel: return &Pulsar::renderModulators<Routing::parallel, Modulation::phase>;
+            case Routing::serial:   return &Pulsar::renderModulators<Routing::serial,   Modulation::phase>;
+            case Routing::feedback: return &Pulsar::renderModulators<Routing::feedback, Modulation::phase>;
+        }
+    }
+
+    switch (routingToUse)
+    {
+        case Routing::parallel: return &Pulsar::renderModulators<Routing::parallel, Modulation::frequency>;
+        case Routing::serial:   return &Pulsar::renderModulators<Routing::serial,   Modulation::frequency>;
+        case Routing::feedback: return &Pulsar::renderModulators<Routing::feedback, Modulation::frequency>;
+    }
+
+    return &Pulsar::renderModulators<Routing::parallel, Modulation::frequency>;
+}
+
+void Pulsar::setNumWavelets(int newNumWavelets)
+{
+    newNumWavelets = juce::jlimit(1, maxWavelets, newNumWavelets);
+
+    if (newNumWavelets == numWavelets)
+        return;
+
+    numWavelets = newNumWavelets;
+}
+
+int Pulsar::getNumWavelets() const
+{
+    return numWavelets;
+}
+
+void Pulsar::updateSpreadRatios(float spread)
+{
+    if (spread == spreadRatiosSpread && numWavelets <= spreadRatiosCount)
+        return;
+
     for (int i = 0; i < numWavelets; ++i)
+        spreadRatios[i] = std::pow((float)(i + 1) * spread, 1.5f);
+
+    spreadRatiosSpread = spread;
+    spreadRatiosCount = numWavelets;
+}
+
+void Pulsar::setPhaseMode(PhaseMode newMode)
+{
+    if (newMode == phaseMode)
+        return;
+
+    /* carry the phases over so switching does not click. */
+    if (newMode == PhaseMode::fixedPoint)
     {
-        _formants[i] = (1.0f / formant);
+        for (int i = 0; i < maxWavelets; ++i)
+            carrierPhases[i] = toFixedPoint(carrierPhasors[i] - std::floor(carrierPhasors[i]));
+
+        modulatorOnePhase = toFixedPoint(modulatorOnePhasor - std::floor(modulatorOnePhasor));
+        modulatorTwoPhase = toFixedPoint(modulatorTwoPhasor - std::floor(modulatorTwoPhasor));
     }
+    else
+    {
+        for (int i = 0; i < maxWavelets; ++i)
+            carrierPhasors[i] = (float)carrierPhases[i] * (1.0f / 4294967296.0f);
+
+        modulatorOnePhasor = (float)modulatorOnePhase * (1.0f / 4294967296.0f);
+        modulatorTwoPhasor = (float)modulatorTwoPhase * (1.0f / 4294967296.0f);
+    }
+
+    phaseMode = newMode;
 }
 
-void Pulsar::setIndex(float index)
+void Pulsar::setSampleRate(double sampleRate)
 {
-    _index = index;
+    invSampleRate = 1.0f / (float)sampleRate;
+
+    fundamentalSmooth .reset(sampleRate, rampLengthSeconds);
+    periodSmooth      .reset(sampleRate, rampLengthSeconds);
+    periodSpreadSmooth.reset(sampleRate, rampLengthSeconds);
+    formantSmooth     .reset(sampleRate, rampLengthSeconds);
+    indexSmooth       .reset(sampleRate, rampLengthSeconds);
 }
 
-void Pulsar::setStochasticMasking(int maskingPercentage)
+
+void Pulsar::changeSampleRate(double sampleRate)
 {
-    _maskingPercentage = maskingPercentage;
+    invSampleRate = 1.0f / (float)sampleRate;
+
+    fundamentalSmooth .changeSampleRate(sampleRate, rampLengthSeconds);
+    periodSmooth      .changeSampleRate(sampleRate, rampLengthSeconds);
+    periodSpreadSmooth.changeSampleRate(sampleRate, rampLengthSeconds);
+    formantSmooth     .changeSampleRate(sampleRate, rampLengthSeconds);
+    indexSmooth       .changeSampleRate(sampleRate, rampLengthSeconds);
 }
 
+float Pulsar::getHighestFrequency() const
+{
+    constexpr auto twoPi = juce::MathConstants<float>::twoPi;
+
+    auto baseFrequency = std::abs(fundamentalSmooth.getTargetValue() / formantSmooth.getTargetValue() * periodSmooth.getTargetValue());
+    auto highestCarrier = baseFrequency * std::pow((float)numWavelets * std::abs(periodSpreadSmooth.getTargetValue()), 1.5f);
+    auto index = std::abs(indexSmooth.getTargetValue());
+
+    if (index == 0.0f)
+        return highestCarrier;
+
+    auto modulatorOneFrequency = baseFrequency * std::abs(ratioTwo);
+    auto modulatorTwoFrequency = baseFrequency * std::abs(ratioOne);
+
+    /* self modulation spreads modulatorOne much as modulating it by a copy of itself would. */
+    if (routing == Routing::feedback)
+        modulatorOneFrequency *= 1.0f + twoPi * std::abs(feedback);
+
+    /* the peak deviation of phase modulation is 2 pi * depth (cycles) * modulating frequency. */
+    auto deviationOne = (modulation == Modulation::phase) ? twoPi * phaseIndexOne * index * modulatorOneFrequency : indexOne * index;
+    auto deviationTwo = (modulation == Modulation::phase) ? twoPi * phaseIndexTwo * index * modulatorTwoFrequency : indexTwo * index;
+
+    /* in series modulatorTwo widens modulatorOne, which alone modulates the carriers. */
+    if (routing == Routing::serial)
+    {
+        modulatorOneFrequency += deviationTwo + modulatorTwoFrequency;
+
+        if (modulation == Modulation::phase)
+            deviationOne = twoPi * phaseIndexOne * index * modulatorOneFrequency;
+
+        return highestCarrier + deviationOne + modulatorOneFrequency;
+    }
+
+    return highestCarrier + deviationOne + deviationTwo + juce::jmax(modulatorOneFrequency, modulatorTwoFrequency);
+}
 
 float Pulsar::getNextSample(float sampleRate)
 {
-    /* Phasor used to trigger or 'spawn' pulsars. */
-    phasor += _fundamental * (1.0f / sampleRate);
-    phasor -= (int)phasor;
+    if (phaseMode == PhaseMode::fixedPoint)
+    {
+        auto output = 0.0f;
+        renderChunk(&output, nullptr, 1);
+        return output;
+    }
+
+    /* step each parameter ramp by one sample. */
+    auto _fundamental = fundamentalSmooth.getNextValue();
+    auto _period = periodSmooth.getNextValue();
+    auto _periodSpread = periodSpreadSmooth.getNextValue();
+    auto _inverseFormant = 1.0f / formantSmooth.getNextValue();
+    auto _index = indexSmooth.getNextValue();
 
     /*
-    * when the direction is negative the phasor has returned to zero.
-    * If negative spawn returns true.
+    * Phasor used to trigger or 'spawn' pulsars, kept by the scheduler.
+    * onset is true when it returns to zero and a new pulse starts.
     */
-    bool spawn = (phasor - previousPhasor > 0.0) ? true : false;
-
-    /* Keep track of the difference between successive samples. 'delta' */
-    previousPhasor = phasor;
+    bool onset = scheduler.advance(toFixedPoint(_fundamental * (1.0f / sampleRate)));
 
     /* 'Drive' the window at the fundamental frequency of the pulsar system. */
     fundamentalPhasor += _fundamental * (1.0f / sampleRate);
    
     /* 
-    * Create random number between 0 and 99, only reset if the random number is greater than the masking value.
-    * When the inner conditional returns true reset all the phasors.
+    * at each onset the mask decides, once for the pulse, whether it sounds.
+    * When it does reset all the phasors.
     * Previously I had used the Rate object to multiply the frequency of each phasor but this proved
     * problematic for frequency modulation.
     */
-    if (!spawn)
+    if (onset)
     {
-        if (random.nextInt(100) >= _maskingPercentage)
+        if (pulseMask.nextPulse())
         {
-            fundamentalPhasor = 0.0f;
+            fundamentalPhasor  = 0.0f;
+            modulatorOnePhasor = 0.0f;
+            modulatorTwoPhasor = 0.0f;
+            windowPhasor       = 0.0f;
+            windowClosed       = false;
 
             for (int i = 0; i < numWavelets; ++i)
-            {
-                modulatorOnePhasors [i] = 0.0f;
-                modulatorTwoPhasors [i] = 0.0f;
-                carrierPhasors      [i] = 0.0f;
-                windowPhasors       [i] = 0.0f;
-            }
+                carrierPhasors[i] = 0.0f;
         }
     }
     
+    /*
+    * each phasor's frequency is multiplied by the formant and then a ratio that
+    * you might expect to see in a frequency modulation system.
+    *
+    * modulatorTwo always runs freely, see Routing for where it and modulatorOne go.
+    * With frequency modulation the modulators add to an increment (in Hz), with phase modulation
+    * they are added to the phase they modulate (in cycles).
+    *
+    * The modulators and the window do not depend on the wavelet so they are read once per sample.
+    */
+    auto phaseModulating = (modulation == Modulation::phase);
+
+    auto modTwoIncrement = (((_fundamental * _inverseFormant) * _period) * ratioOne) * (1.0f / sampleRate);
+    modulatorTwoPhasor += modTwoIncrement;
+    modulatorTwo.setPhaseIncrement(modTwoIncrement);
+    auto modTwo = modulatorTwo.getNextSample(modulatorTwoPhasor) * (phaseModulating ? phaseIndexTwo : indexTwo);
+
+    if (routing == Routing::serial)
+        modTwo *= _index;
+
+    auto modOneFrequency = ((_fundamental * _inverseFormant) * _period) * ratioTwo;
+
+    if (routing == Routing::serial && !phaseModulating)
+        modOneFrequency += modTwo;
+
+    auto modOneIncrement = modOneFrequency * (1.0f / sampleRate);
+    modulatorOnePhasor += modOneIncrement;
+    modulatorOne.setPhaseIncrement(modOneIncrement);
+    auto modOnePhase = modulatorOnePhasor;
+
+    if (routing == Routing::serial && phaseModulating)
+        modOnePhase = wrapPhase(modOnePhase + modTwo);
+
+    if (routing == Routing::feedback)
+        modOnePhase = wrapPhase(modOnePhase + feedback * feedbackSample);
+
+    auto modOne = modulatorOne.getNextSample(modOnePhase);
+    feedbackSample = modOne;
+    modOne *= phaseModulating ? phaseIndexOne : indexOne;
+
+    /* modulators are summed (unless in series) and scaled before added to each carrier. */
+    auto modOnePlusTwo = (routing == Routing::serial) ? modOne * _index
+                                                      : (modOne + modTwo) * _index;
+
+    /* ensure the phasor does not run past the end of the window, a clamp to squish the window. */
+    windowPhasor = (fundamentalPhasor * _inverseFormant > windowPhaseLimit) ? windowPhaseLimit : fundamentalPhasor * _inverseFormant;
+
+    /*
+    * the sample that closes the window is still read, so the window table is left on its last (silent) index.
+    * After that the carriers are not read again until the reset that opens it, see setSkipSilence.
+    */
+    if (windowClosed)
+    {
+        windowPhasor = windowPhaseLimit;
+
+        if (skipSilence && windowEndsSilent)
+            return 0.0f;
+    }
+    else
+    {
+        windowClosed = (windowPhasor >= windowPhaseLimit);
+    }
+
+    auto windowSample = window.getNextSample(windowPhasor);
+
     /* clear output. */
     auto output = 0.0f;
 
     for (int i = 0; i < numWavelets; ++i)
     {
-        /*
-        * i + 1 so that the first fundamental is multiplied by 1 and not 0.
-        * each phasor's frequency is also multiplied by the formant and then a ratio that
-        * you might expect to see in a frequency modulation system.
-        * 
-        * Here the ratio's are fixed, this of course needs parametising in the future.
-        * This is a parallel modulation system as opposed to a seriers or stacked system.
-        * 
-        * Sadly this is Frequency not Phase modulation.
-        */
-
-        modulatorTwoPhasors[i] += (((_fundamental * _formants[i]) * _period) * ratioOne) * (1.0f / sampleRate);
-        auto modTwo = modulatorsTwo[i]->getNextSample(modulatorTwoPhasors[i]);
-
-        modulatorOnePhasors[i] += ((((_fundamental * _formants[i]) * _period) * ratioTwo) /* + (modTwo * (indexTwo * _index)) */) * (1.0f / sampleRate);
-        auto modOne = modulatorsOne[i]->getNextSample(modulatorOnePhasors[i]);
- 
-        /* modulators are summed and scaled before added to carrier frequency. */
-        auto modOnePlusTwo = ((modOne * indexOne) + (modTwo * indexTwo))  * _index;
-
-        auto carrierFrequency = (_fundamental * _formants[i]) * _period * pow((i + 1) * _periodSpread, 1.5f);
+        /* i + 1 so that the first fundamental is multiplied by 1 and not 0. */
+        auto carrierFrequency = (_fundamental * _inverseFormant) * _period * std::pow((float)(i + 1) * _periodSpread, 1.5f);
         
-        carrierPhasors[i] += (carrierFrequency  + modOnePlusTwo) * (1.0f / sampleRate);
+        auto carrierIncrement = (phaseModulating ? carrierFrequency : carrierFrequency + modOnePlusTwo) * (1.0f / sampleRate);
+        carrierPhasors[i] += carrierIncrement;
+        wavelets[i]->setPhaseIncrement(carrierIncrement);
 
-        /* ensure the phasor does not exceed one, a clamp to squish the window. */
-        windowPhasors[i] = (fundamentalPhasor * _formants[i] > 1.0f) ? 1.0f : fundamentalPhasor * _formants[i];
+        auto carrierPhase = phaseModulating ? wrapPhase(carrierPhasors[i] + modOnePlusTwo) : carrierPhasors[i];
 
-        output += wavelets[i]->getNextSample(carrierPhasors[i]) * windows[i]->getNextSample(windowPhasors[i]);
+        /* 'window' the resulting waveforms and scale output by number of pulsarets. */
+        output += wavelets[i]->getNextSample(carrierPhase) * windowSample;
     }
 
-    /* clear output. */
-    // auto output = 0.0f;
+    return output * (1.0f / (float)numWavelets);
+}
 
-    /* 'window' the resulting waveforms and scale output by number of pulsarets. */
-    // for (int i = 0; i < numWavelets; ++i)
-    // {
-    //     output += wavelets[i]->getNextSample(carrierPhasors[i]) * windows[i]->getNextSample(windowPhasors[i]);
-    // }
+void Pulsar::renderBlock(float* out, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        auto numThisTime = juce::jmin(numSamples, blockSize);
 
-    return output * (1.0f / (float)numWavelets);
-}
\ No newline at end of file
+        renderChunk(out, nullptr, numThisTime);
+
+        out        += numThisTime;
+        numSamples -= numThisTime;
+    }
+}
+
+/*
+* Block kernel, each stage of getNextSample is run over the whole chunk before moving on to the next.
+* The arithmetic is kept in the same order as getNextSample so both paths give identical output.
+* The phasor recurrences are serial, everything else is done with juce::FloatVectorOperations (SSE/NEON).
+* The chunk is split at the pulse resets so the phasor loops in between have no data dependent branches.
+*/
+bool Pulsar::renderWaveletsSeparately(float* const* outputs, int numSamples)
+{
+    jassert(numSamples <= blockSize);
+    return renderChunk(nullptr, outputs, numSamples);
+}
+
+bool Pulsar::renderChunk(float* out, float* const* waveletOutputs, int numSamples)
+{
+    /*
+    * parameter ramps, one value per sample. A parameter that is not gliding is a fill,
+    * so the divide for the formant and the pow for the spread only run per sample while they glide.
+    */
+    auto fundamentalGliding = fundamentalSmooth.isSmoothing();
+    auto formantGliding = formantSmooth.isSmoothing();
+    fundamentalSmooth.fillRamp(fundamentalRamp.data(), numSamples);
+    periodSmooth.fillRamp(periodRamp.data(), numSamples);
+    indexSmooth.fillRamp(indexRamp.data(), numSamples);
+
+    if (formantGliding)
+    {
+        for (int n = 0; n < numSamples; ++n)
+            inverseFormantRamp[n] = 1.0f / formantSmooth.getNextValue();
+    }
+    else
+    {
+        juce::FloatVectorOperations::fill(inverseFormantRamp.data(), 1.0f / formantSmooth.getTargetValue(), numSamples);
+    }
+
+    auto spreadGliding = periodSpreadSmooth.isSmoothing();
+    periodSpreadSmooth.fillRamp(spreadRamp.data(), numSamples);
+
+    /* (fundamental * 1 / formant) * period, shared by every wavelet. */
+    juce::FloatVectorOperations::multiply (baseFrequencyBuffer.data(), fundamentalRamp.data(), inverseFormantRamp.data(), numSamples);
+    juce::FloatVectorOperations::multiply (baseFrequencyBuffer.data(), periodRamp.data(), numSamples);
+
+    /*
+    * pulse onsets come from the scheduler, the mask is asked once per onset.
+    * resets holds the samples where a sounding pulse resets the phasors, everything in between
+    * is a segment without branches.
+    */
+    juce::FloatVectorOperations::multiply (incrementBuffer.data(), fundamentalRamp.data(), invSampleRate, numSamples);
+
+    int numOnsets;
+
+    if (fundamentalGliding)
+    {
+        for (int n = 0; n < numSamples; ++n)
+            fixedPhaseBuffer[n] = toFixedPoint(incrementBuffer[n]);
+
+        numOnsets = scheduler.findOnsets(fixedPhaseBuffer.data(), numSamples, onsets.data());
+    }
+    else
+    {
+        numOnsets = scheduler.findOnsets(toFixedPoint(incrementBuffer[0]), numSamples, onsets.data());
+    }
+
+    numResets = 0;
+
+    for (int k = 0; k < numOnsets; ++k)
+    {
+        if (pulseMask.nextPulse())
+            resets[numResets++] = onsets[k];
+    }
+
+    /* the window is driven from zero, it is exactly 0 on the reset sample itself. */
+    auto start = 0;
+
+    for (int r = 0; r <= numResets; ++r)
+    {
+        auto end = (r < numResets) ? resets[r] : numSamples;
+
+        for (int n = start; n < end; ++n)
+        {
+            fundamentalPhasor += incrementBuffer[n];
+            fundamentalBuffer[n] = fundamentalPhasor;
+        }
+
+        if (r < numResets)
+        {
+            fundamentalPhasor = 0.0f;
+            fundamentalBuffer[end] = 0.0f;
+            ++end;
+        }
+
+        start = end;
+    }
+
+    /*
+    * the clamped window phasor. While the formant is steady the phase only rises between resets,
+    * so the window stays closed by itself and only the last sample needs checking.
+    */
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), fundamentalBuffer.data(), inverseFormantRamp.data(), numSamples);
+    juce::FloatVectorOperations::min      (phaseBuffer.data(), phaseBuffer.data(), windowPhaseLimit, numSamples);
+
+    /*
+    * the float table read returns the phase it was given the sample before, so a chunk is only silent
+    * if the last chunk already ended on the closed window. The sample that closes it is still read.
+    */
+    auto closedBefore = (windowPhasor >= windowPhaseLimit);
+
+    if (windowClosed || formantGliding)
+        latchWindowPhases(numSamples);
+    else
+        windowClosed = (phaseBuffer[numSamples - 1] >= windowPhaseLimit);
+
+    windowPhasor = phaseBuffer[numSamples - 1];
+
+    if (!spreadGliding)
+        updateSpreadRatios(periodSpreadSmooth.getTargetValue());
+
+    /* closed since before the first sample with no reset to open it, the whole chunk is silent. */
+    if (skipSilence && windowEndsSilent && numResets == 0 && closedBefore && phaseBuffer[0] >= windowPhaseLimit)
+    {
+        advanceModulators(numSamples);
+
+        if (out != nullptr)
+            juce::FloatVectorOperations::clear(out, numSamples);
+
+        return false;
+    }
+
+    if (phaseMode == PhaseMode::fixedPoint)
+    {
+        /* a window phase of 1 wraps to 0, the same as the float table read does. */
+        for (int n = 0; n < numSamples; ++n)
+            fixedPhaseBuffer[n] = toFixedPoint(phaseBuffer[n]);
+
+        window.processBlock(fixedPhaseBuffer.data(), windowBuffer.data(), numSamples);
+    }
+    else
+    {
+        window.processBlock(phaseBuffer.data(), windowBuffer.data(), numSamples);
+    }
+
+    /* modulators, the result is left in modulatorOneBuffer for every carrier. */
+    (this->*modulatorKernel)(numSamples);
+
+    renderWavelets(out, waveletOutputs, numSamples, spreadGliding);
+    return true;
+}
+
+void Pulsar::latchWindowPhases(int numSamples)
+{
+    auto r = 0;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        if (r < numResets && resets[r] == n)
+        {
+            windowClosed = false;
+            ++r;
+        }
+
+        if (windowClosed)
+            phaseBuffer[n] = windowPhaseLimit;
+        else
+            windowClosed = (phaseBuffer[n] >= windowPhaseLimit);
+    }
+}
+
+void Pulsar::renderWavelets(float* out, float* const* waveletOutputs, int numSamples, bool spreadGliding)
+{
+    const auto count = numWavelets;
+    const auto scale = 1.0f / (float)count;
+
+    if (waveletOutputs == nullptr)
+        juce::FloatVectorOperations::clear(out, numSamples);
+
+    for (int i = 0; i < count; ++i)
+    {
+        /* carrier frequency, baseFrequency * ((i + 1) * spread)^1.5, then the FM and the carrier increment. */
+        if (spreadGliding)
+        {
+            for (int n = 0; n < numSamples; ++n)
+                carrierBuffer[n] = baseFrequencyBuffer[n] * std::pow((float)(i + 1) * spreadRamp[n], 1.5f);
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply (carrierBuffer.data(), baseFrequencyBuffer.data(), spreadRatios[i], numSamples);
+        }
+
+        if (modulation == Modulation::frequency)
+            juce::FloatVectorOperations::add (carrierBuffer.data(), modulatorOneBuffer.data(), numSamples);
+
+        juce::FloatVectorOperations::multiply (carrierBuffer.data(), invSampleRate, numSamples);
+
+        /* the mipmap level follows the fastest the carrier moves in this chunk. */
+        wavelets[i]->setPhaseIncrement(getLargestMagnitude(carrierBuffer.data(), numSamples));
+
+        readPhases(*wavelets[i], carrierPhasors[i], carrierPhases[i], carrierBuffer.data(), carrierBuffer.data(), numSamples,
+                   (modulation == Modulation::phase) ? modulatorOneBuffer.data() : nullptr);
+
+        juce::FloatVectorOperations::multiply (carrierBuffer.data(), windowBuffer.data(), numSamples);
+
+        if (waveletOutputs != nullptr)
+            juce::FloatVectorOperations::multiply (waveletOutputs[i], carrierBuffer.data(), scale, numSamples);
+        else
+            juce::FloatVectorOperations::add      (out, carrierBuffer.data(), numSamples);
+    }
+
+    if (waveletOutputs == nullptr)
+        juce::FloatVectorOperations::multiply(out, scale, numSamples);
+}
+
+/*
+* the modulator stage of renderChunk, see Routing. Each routing and modulation pair is its own
+* instantiation, so the parallel frequency modulation costs what it did before there was a choice.
+*/
+template <Pulsar::Routing routingToUse, Pulsar::Modulation modulationToUse>
+void Pulsar::renderModulators(int numSamples)
+{
+    constexpr auto phaseModulating = (modulationToUse == Modulation::phase);
+    constexpr auto serial = (routingToUse == Routing::serial);
+
+    /* phaseBuffer holds the increments and is then overwritten with the phases. */
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), baseFrequencyBuffer.data(), ratioOne, numSamples);
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), invSampleRate, numSamples);
+    modulatorTwo.setPhaseIncrement(getLargestMagnitude(phaseBuffer.data(), numSamples));
+    readPhases(modulatorTwo, modulatorTwoPhasor, modulatorTwoPhase, phaseBuffer.data(), modulatorTwoBuffer.data(), numSamples);
+    juce::FloatVectorOperations::multiply (modulatorTwoBuffer.data(), phaseModulating ? phaseIndexTwo : indexTwo, numSamples);
+
+    if (serial)
+        juce::FloatVectorOperations::multiply (modulatorTwoBuffer.data(), indexRamp.data(), numSamples);
+
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), baseFrequencyBuffer.data(), ratioTwo, numSamples);
+
+    if (serial && !phaseModulating)
+        juce::FloatVectorOperations::add (phaseBuffer.data(), modulatorTwoBuffer.data(), numSamples);
+
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), invSampleRate, numSamples);
+    modulatorOne.setPhaseIncrement(getLargestMagnitude(phaseBuffer.data(), numSamples));
+
+    if (routingToUse == Routing::feedback)
+    {
+        readWithFeedback(modulatorOne, modulatorOnePhasor, modulatorOnePhase, phaseBuffer.data(), modulatorOneBuffer.data(), numSamples);
+    }
+    else
+    {
+        readPhases(modulatorOne, modulatorOnePhasor, modulatorOnePhase, phaseBuffer.data(), modulatorOneBuffer.data(), numSamples,
+                   (serial && phaseModulating) ? modulatorTwoBuffer.data() : nullptr);
+
+        /* kept up to date so switching to the feedback routing carries on smoothly. */
+        feedbackSample = modulatorOneBuffer[numSamples - 1];
+    }
+
+    juce::FloatVectorOperations::multiply (modulatorOneBuffer.data(), phaseModulating ? phaseIndexOne : indexOne, numSamples);
+
+    /* (modOne + modTwo) * index, in series modulatorTwo has already gone into modulatorOne. */
+    if (!serial)
+        juce::FloatVectorOperations::add (modulatorOneBuffer.data(), modulatorTwoBuffer.data(), numSamples);
+
+    juce::FloatVectorOperations::multiply (modulatorOneBuffer.data(), indexRamp.data(), numSamples);
+}
+
+/*
+* the carriers of a silent chunk are not needed, a reset comes before they are read again.
+* In parallel the modulators only keep their phases. The float tables return the index they were given the
+* sample before, so the last two phases are still read, leaving each table and feedbackSample where a full render would.
+* In series and with feedback a modulator's output moves its phase, so those are rendered in full.
+*/
+void Pulsar::advanceModulators(int numSamples)
+{
+    if (routing != Routing::parallel)
+    {
+        (this->*modulatorKernel)(numSamples);
+        return;
+    }
+
+    auto numToRead = juce::jmin(2, numSamples);
+    auto first = numSamples - numToRead;
+
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), baseFrequencyBuffer.data(), ratioOne, numSamples);
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), invSampleRate, numSamples);
+    modulatorTwo.setPhaseIncrement(getLargestMagnitude(phaseBuffer.data(), numSamples));
+    advancePhases(modulatorTwo, modulatorTwoPhasor, modulatorTwoPhase, first, numToRead, numSamples);
+
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), baseFrequencyBuffer.data(), ratioTwo, numSamples);
+    juce::FloatVectorOperations::multiply (phaseBuffer.data(), invSampleRate, numSamples);
+    modulatorOne.setPhaseIncrement(getLargestMagnitude(phaseBuffer.data(), numSamples));
+    advancePhases(modulatorOne, modulatorOnePhasor, modulatorOnePhase, first, numToRead, numSamples);
+
+    feedbackSample = modulatorOneBuffer[numToRead - 1];
+}
+
+/* accumulates the increments in phaseBuffer and reads only the last numToRead phases into modulatorOneBuffer. */
+void Pulsar::advancePhases(Wavetable& table, float& phasor, juce::uint32& phase, int first, int numToRead, int numSamples)
+{
+    if (phaseMode == PhaseMode::fixedPoint)
+    {
+        accumulate(phase, phaseBuffer.data(), fixedPhaseBuffer.data(), numSamples);
+        table.processBlock(fixedPhaseBuffer.data() + first, modulatorOneBuffer.data(), numToRead);
+        return;
+    }
+
+    accumulate(phasor, phaseBuffer.data(), phaseBuffer.data(), numSamples);
+    table.processBlock(phaseBuffer.data() + first, modulatorOneBuffer.data(), numToRead);
+}
+
+void Pulsar::readPhases(Wavetable& table, float& phasor, juce::uint32& phase, const float* increments, float* output, int numSamples,
+                        const float* phaseOffsets)
+{
+    if (phaseMode == PhaseMode::fixedPoint)
+    {
+        accumulate(phase, increments, fixedPhaseBuffer.data(), numSamples);
+
+        if (phaseOffsets != nullptr)
+        {
+            for (int n = 0; n < numSamples; ++n)
+                fixedPhaseBuffer[n] += toFixedPoint(phaseOffsets[n]);
+        }
+
+        table.processBlock(fixedPhaseBuffer.data(), output, numSamples);
+        return;
+    }
+
+    accumulate(phasor, increments, phaseBuffer.data(), numSamples);
+
+    if (phaseOffsets != nullptr)
+    {
+        for (int n = 0; n < numSamples; ++n)
+            phaseBuffer[n] = wrapPhase(phaseBuffer[n] + phaseOffsets[n]);
+    }
+
+    table.processBlock(phaseBuffer.data(), output, numSamples);
+}
+
+/* each phase depends on the sample read just before it, so the table is read one sample at a time. */
+void Pulsar::readWithFeedback(Wavetable& table, float& phasor, juce::uint32& phase, const float* increments, float* output, int numSamples)
+{
+    if (phaseMode == PhaseMode::fixedPoint)
+    {
+        accumulate(phase, increments, fixedPhaseBuffer.data(), numSamples);
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            juce::uint32 feedbackPhase = fixedPhaseBuffer[n] + toFixedPoint(feedback * feedbackSample);
+            table.processBlock(&feedbackPhase, output + n, 1);
+            feedbackSample = output[n];
+        }
+
+        return;
+    }
+
+    accumulate(phasor, increments, phaseBuffer.data(), numSamples);
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        auto feedbackPhase = wrapPhase(phaseBuffer[n] + feedback * feedbackSample);
+        table.processBlock(&feedbackPhase, output + n, 1);
+        feedbackSample = output[n];
+    }
+}
+
+/*
+* the phasor runs freely between resets, on a reset sample it starts again from that sample's increment.
+* increments and phases may be the same buffer.
+*/
+void Pulsar::accumulate(float& phasor, const float* increments, float* phases, int numSamples) const
+{
+    auto start = 0;
+
+    for (int r = 0; r <= numResets; ++r)
+    {
+        auto end = (r < numResets) ? resets[r] : numSamples;
+
+        for (int n = start; n < end; ++n)
+        {
+            phasor += increments[n];
+            phases[n] = phasor;
+        }
+
+        if (r < numResets)
+            phasor = 0.0f;
+
+        start = end;
+    }
+}
+
+/* fixed point version, a negative (FM) increment wraps backwards as it should. */
+void Pulsar::accumulate(juce::uint32& phase, const float* increments, juce::uint32* phases, int numSamples) const
+{
+    auto start = 0;
+
+    for (int r = 0; r <= numResets; ++r)
+    {
+        auto end = (r < numResets) ? resets[r] : numSamples;
+
+        for (int n = start; n < end; ++n)
+        {
+            phase += toFixedPoint(increments[n]);
+            phases[n] = phase;
+        }
+
+        if (r < numResets)
+            phase = 0;
+
+        start = end;
+    }
+}
+
+float Pulsar::wrapPhase(float phase)
+{
+    return phase - std::floor(phase);
+}
+
+juce::uint32 Pulsar::toFixedPoint(float phase)
+{
+    /* only the fractional part of the phase matters, the cast through int64 keeps negative phases in range. */
+    return (juce::uint32)(juce::int64)(phase * 4294967296.0f);
+}
+
+float Pulsar::getLargestMagnitude(const float* values, int numSamples)
+{
+    auto range = juce::FloatVectorOperations::findMinAndMax(values, numSamples);
+    return juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd()));
+}
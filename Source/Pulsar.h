@@ -11,38 +11,256 @@
 
 #include <JuceHeader.h>
 #include "Wavetable.h"
+#include "WindowTables.h"
+#include "Smooth.h"
+#include "PulseMask.h"
+#include "PulseScheduler.h"
 
 class Pulsar
 {
 public:
-    Pulsar(const juce::AudioSampleBuffer& waveTableToUse, const juce::AudioSampleBuffer& windowTableToUse);
+    Pulsar(const WavetableMipmap& waveTableToUse, const juce::AudioSampleBuffer& windowTableToUse, int numWaveletsToUse = 3);
+
+    /* the window is read straight from the compile time WindowTables, nothing is built. */
+    Pulsar(const WavetableMipmap& waveTableToUse, WindowTables::Shape windowShape = WindowTables::Shape::hann, int numWaveletsToUse = 3);
     ~Pulsar();
     float getNextSample(float sampleRate);
-    void setFundamental(float fundamental);
-    void setPeriod(float period, float spread);
-    void setFormant(float formant);
-    void setIndex(float index);
+
+    /*
+    * block version of getNextSample, fills out with numSamples of output.
+    * produces the same output as calling getNextSample numSamples times, as long as the
+    * carrier mipmap level does not change within a chunk (getNextSample picks it every sample).
+    */
+    void renderBlock(float* out, int numSamples);
+
+    /*
+    * renderBlock for one chunk (numSamples up to blockSize), with wavelet i written to outputs[i] instead of
+    * summed, each already scaled by 1 / getNumWavelets() so together they add up to renderBlock's output.
+    * returns false, with the outputs left as they were, when the chunk is silent (see setSkipSilence).
+    */
+    bool renderWaveletsSeparately(float* const* outputs, int numSamples);
+    void setSampleRate(double sampleRate);
+
+    /* like setSampleRate but glides in progress carry on, for changing the oversampling factor mid note. */
+    void changeSampleRate(double sampleRate);
+
+    /*
+    * an estimate of the highest frequency in the output (Hz) once the parameters reach their targets.
+    * Carson's rule: the highest carrier, plus the peak FM deviation, plus the frequency modulating it.
+    * The voice compares this with the sample rate to decide how far to oversample.
+    */
+    float getHighestFrequency() const;
+
+    /*
+    * the synthesis parameters glide to their new value over rampLengthSeconds,
+    * pass shouldGlide = false to jump straight there, at the start of a note for example.
+    */
+    void setFundamental(float fundamental, bool shouldGlide = true);
+    void setPeriod(float period, float spread, bool shouldGlide = true);
+    void setFormant(float formant, bool shouldGlide = true);
+    void setIndex(float index, bool shouldGlide = true);
     void setStochasticMasking(int maskingPercentage);
+
+    /* see PulseMask, a pattern of length 0 masks at random. The same seed gives the same masking every run. */
+    void setMaskingPattern(juce::uint32 pattern, int length);
+    void setMaskingSeed(juce::uint64 seed);
+
+    /*
+    * floatingPoint is the original phasor arithmetic.
+    * fixedPoint keeps every phase as a 32 bit integer where 2^32 is one cycle, phases wrap for free
+    * and do not lose precision however long the pulsar runs. FM is added as an integer increment.
+    * Only renderBlock runs in fixed point, getNextSample renders a single sample block in this mode.
+    */
+    enum class PhaseMode
+    {
+        floatingPoint,
+        fixedPoint
+    };
+
+    void setPhaseMode(PhaseMode newMode);
+
+    /*
+    * the operators are modulatorTwo (ratioOne), modulatorOne (ratioTwo) and each wavelet's carrier.
+    * parallel: both modulators modulate the carriers, the original routing.
+    * serial:   modulatorTwo modulates modulatorOne, which modulates the carriers.
+    * feedback: parallel, with modulatorOne also phase modulating itself by its previous sample.
+    *
+    * frequency modulation adds the modulators to the carrier increment (indexOne and indexTwo in Hz),
+    * phase modulation adds them to the carrier phase (phaseIndexOne and phaseIndexTwo in cycles).
+    * Self feedback is always phase modulation, as on the DX7.
+    */
+    enum class Routing
+    {
+        parallel,
+        serial,
+        feedback
+    };
+
+    enum class Modulation
+    {
+        frequency,
+        phase
+    };
+
+    void setModulation(Routing newRouting, Modulation newModulation);
+
+    /* modulator frequencies as a multiple of the formant frequency. */
+    void setModulatorRatios(float newRatioOne, float newRatioTwo);
+
+    /* self modulation of the feedback routing in cycles, around 0.1 to 0.5 before it turns to noise. */
+    void setFeedback(float newFeedback);
+
+    /*
+    * number of waveforms within a single envelope, 1 to maxWavelets.
+    * every wavelet is allocated up front, so this can be called from the audio thread.
+    */
+    void setNumWavelets(int newNumWavelets);
+    int getNumWavelets() const;
+    static constexpr int maxWavelets = 64;
+
+    /* crossfade between mipmap levels instead of switching, smoother but reads the carrier tables twice. */
+    void setMipmapCrossfade(bool shouldCrossfade);
+
+    /*
+    * table interpolation for the wavelets (carriers and modulators) and for the window.
+    * the window is smooth and slow, so it can usually be read with none or linear.
+    */
+    void setWaveletInterpolation(Wavetable::Interpolation newInterpolation);
+    void setWindowInterpolation(Wavetable::Interpolation newInterpolation);
+
+    /* pulsaret window (envelope) shape, just a pointer change so it can be called from the audio thread. */
+    void setWindowShape(WindowTables::Shape newShape);
+
+    /*
+    * a window from a buffer of tableSize + 1 samples instead, a frame of a MappedWavetableBank for example.
+    * Like a WindowTables table the phase is held on its last sample once the window has closed. Nothing is copied.
+    */
+    void setWindowTable(const juce::AudioSampleBuffer& windowTableToUse);
+
+    /*
+    * the carriers read this mipmap instead of the one given to the constructor, the modulators stay as they are.
+    * Nothing is copied and nothing changes if it is already in use, so it can be called every block.
+    * A freed mipmap's address can be reused by the next, so a table from a TableSet is told apart by the
+    * set's generation as well, a new generation always sets it.
+    */
+    void setWaveletTable(const WavetableMipmap& waveTableToUse, juce::uint32 tableGeneration = 0);
+
+    /*
+    * once a pulsaret's window has closed nothing sounds until the next pulse resets every phasor,
+    * so renderBlock skips the carriers and the table reads for chunks that are silent from start to end.
+    * Only windows whose last sample is 0 are skipped, as every WindowTables one is. The output is the same either way,
+    * this is here to measure the difference.
+    */
+    void setSkipSilence(bool shouldSkip);
+
+    /* renderBlock works through the output in chunks of this size. */
+    static constexpr int blockSize = 64;
+
+    /* time taken by a parameter change, the same whatever the host block size. */
+    static constexpr double rampLengthSeconds = 0.05;
 private:
-    /* number of waveforms within a single envelope. */
-    int numWavelets = 3;
-    
+    /* renders into out, or into waveletOutputs one wavelet each when given. returns false for a skipped silent chunk. */
+    bool renderChunk(float* out, float* const* waveletOutputs, int numSamples);
+
+    /* the per wavelet stage of renderChunk, one vector pass per wavelet over the chunk. */
+    void renderWavelets(float* out, float* const* waveletOutputs, int numSamples, bool spreadGliding);
+
+    /* the modulator stage of renderChunk, leaves the carrier modulation in modulatorOneBuffer. */
+    template <Routing routingToUse, Modulation modulationToUse>
+    void renderModulators(int numSamples);
+
+    /* renderModulators for a silent chunk, keeps the modulator state without reading what it is not needed for. */
+    void advanceModulators(int numSamples);
+    void advancePhases(Wavetable& table, float& phasor, juce::uint32& phase, int first, int numToRead, int numSamples);
+
+    /* holds the window phases in phaseBuffer closed from the end of the window to the next reset. */
+    void latchWindowPhases(int numSamples);
+
+    using ModulatorKernel = void (Pulsar::*)(int);
+    static ModulatorKernel getModulatorKernel(Routing routingToUse, Modulation modulationToUse);
+    void updateSpreadRatios(float spread);
+    static void setSmoothTarget(Smooth& smooth, float target, bool shouldGlide);
+    static float getLargestMagnitude(const float* values, int numSamples);
+    static juce::uint32 toFixedPoint(float phase);
+    static float wrapPhase(float phase);
+
+    /*
+    * accumulates the increments into the phase (float or fixed point, whichever is in use) and reads the table.
+    * phaseOffsets, when given, are added to the phases before the read (phase modulation).
+    */
+    void readPhases(Wavetable& table, float& phasor, juce::uint32& phase, const float* increments, float* output, int numSamples,
+                    const float* phaseOffsets = nullptr);
+    void readWithFeedback(Wavetable& table, float& phasor, juce::uint32& phase, const float* increments, float* output, int numSamples);
+    void accumulate(float& phasor, const float* increments, float* phases, int numSamples) const;
+    void accumulate(juce::uint32& phase, const float* increments, juce::uint32* phases, int numSamples) const;
+
+
+    int numWavelets = 0;
+
+    Routing routing = Routing::parallel;
+    Modulation modulation = Modulation::frequency;
+    ModulatorKernel modulatorKernel = &Pulsar::renderModulators<Routing::parallel, Modulation::frequency>;
+
+    /*
+    * the window and the modulators run at the same rate and reset together for every wavelet,
+    * so there is one of each rather than one per wavelet. Only the carriers differ.
+    */
     juce::OwnedArray<Wavetable> wavelets;
-    juce::OwnedArray<Wavetable> windows;
-    juce::OwnedArray<Wavetable> modulatorsOne, modulatorsTwo;
+    Wavetable window, modulatorOne, modulatorTwo;
+    const WavetableMipmap* waveletTable;
+    juce::uint32 waveletTableGeneration = 0;
 
-    std::vector<float> _formants;
-    std::vector<float> waveletPhasors;
-    std::vector<float> windowPhasors;
-    std::vector<float> carrierPhasors, modulatorOnePhasors, modulatorTwoPhasors;
+    /*
+    * the window phasor is clamped here once the pulse has finished. The buffer constructor's window holds the phase
+    * at 1, which wraps round to its first sample, the others hold it on their last sample, silent if windowEndsSilent.
+    */
+    float windowPhaseLimit = 1.0f;
+    bool windowEndsSilent = false;
+
+    float windowPhasor = 0.0f, modulatorOnePhasor = 0.0f, modulatorTwoPhasor = 0.0f;
+
+    /*
+    * set once the window reaches windowPhaseLimit, cleared by the next reset. A formant gliding up
+    * shrinks the window phase, this keeps a finished pulsaret from opening again part way through.
+    */
+    bool windowClosed = false;
+    bool skipSilence = true;
+    juce::uint32 modulatorOnePhase = 0, modulatorTwoPhase = 0;
+
+    /* per wavelet state, kept as aligned arrays (structure of arrays) for the block kernel. */
+    alignas (16) std::array<float, maxWavelets> carrierPhasors {};
+    alignas (16) std::array<juce::uint32, maxWavelets> carrierPhases {};
+
+    /* ((i + 1) * spread)^1.5 for each wavelet, worked out again only when the spread or the count changes. */
+    alignas (16) std::array<float, maxWavelets> spreadRatios {};
+    float spreadRatiosSpread = 0.0f;
+    int spreadRatiosCount = 0;
+
+    /* scratch buffers used by renderBlock, one chunk long. */
+    alignas (16) std::array<float, blockSize> fundamentalBuffer {}, incrementBuffer {};
+    alignas (16) std::array<float, blockSize> phaseBuffer {}, modulatorOneBuffer {}, modulatorTwoBuffer {};
+    alignas (16) std::array<float, blockSize> carrierBuffer {}, windowBuffer {};
+
+    alignas (16) std::array<juce::uint32, blockSize> fixedPhaseBuffer {};
+
+    /* pulse onsets in the current chunk, and the ones the mask let through, which reset the phasors. */
+    std::array<int, blockSize> onsets {}, resets {};
+    int numResets = 0;
+
+    /* parameter ramps for the current chunk, the formant is stored as its reciprocal. */
+    alignas (16) std::array<float, blockSize> fundamentalRamp {}, periodRamp {}, spreadRamp {};
+    alignas (16) std::array<float, blockSize> inverseFormantRamp {}, indexRamp {}, baseFrequencyBuffer {};
    
-    float phasor = 0.0f, previousPhasor = 0.0f;
+    PulseScheduler scheduler;
     float fundamentalPhasor = 0.0f;
 
-    float _fundamental = 0.0f;
-    float _period = 0.0f, _periodSpread = 0.0f;
-    float _index = 0.0f;
-    int _maskingPercentage = 50;
+    PhaseMode phaseMode = PhaseMode::floatingPoint;
+
+    float invSampleRate = 1.0f / 44100.0f;
+
+    /* frequencies glide exponentially so a glide sounds even across octaves. */
+    Smooth fundamentalSmooth { Smooth::Mode::exponential };
+    Smooth periodSmooth, periodSpreadSmooth, formantSmooth, indexSmooth;
 
     /* I chose these values to create a formant, vowel like sound. */
     float ratioOne = 1.0f;
@@ -51,7 +269,13 @@ private:
     float indexOne = 1000.0f;
     float indexTwo = 1000.0f;
 
+    /* the same at index 1, in cycles, 0.5 is a deviation of pi radians. */
+    float phaseIndexOne = 0.5f;
+    float phaseIndexTwo = 0.5f;
+
+    /* modulatorOne's previous sample, fed back into its phase. */
     float feedback = 0.0f;
+    float feedbackSample = 0.0f;
 
-    juce::Random random;
+    PulseMask pulseMask;
 };
\ No newline at end of file
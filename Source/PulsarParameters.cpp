@@ -0,0 +1,29 @@
+#include "PulsarParameters.h"
+
+PulsarParameterStore::PulsarParameterStore()
+{
+}
+
+PulsarParameterStore::~PulsarParameterStore()
+{
+}
+
+void PulsarParameterStore::publish(const PulsarParameters& parameters)
+{
+    buffers[(size_t)writeIndex] = parameters;
+    writeIndex = spare.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel) & ~newDataFlag;
+}
+
+bool PulsarParameterStore::update()
+{
+    if ((spare.load(std::memory_order_relaxed) & newDataFlag) == 0)
+        return false;
+
+    readIndex = spare.exchange(readIndex, std::memory_order_acq_rel) & ~newDataFlag;
+    return true;
+}
+
+const PulsarParameters& PulsarParameterStore::get() const
+{
+    return buffers[(size_t)readIndex];
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Pulsar.h"
+
+/* every synthesis parameter the gui can change, copied around as a whole. */
+struct PulsarParameters
+{
+    float fundamental = 220.0f;
+    bool  keyboardControl = false;
+    float period = 1.0f, periodSpread = 1.0f;
+    float formant = 1.0f;
+    float index = 0.0f;
+
+    /* operator routing, see Pulsar::Routing. The ratios are multiples of the formant frequency. */
+    Pulsar::Routing routing = Pulsar::Routing::parallel;
+    bool  phaseModulation = false;
+    float ratioOne = 1.0f, ratioTwo = 6.0f;
+    float feedback = 0.0f;
+    int   numPulsarets = 3;
+    WindowTables::Shape windowShape = WindowTables::Shape::hann;
+
+    /* live sets can trade fidelity for cpu, offline renders can afford the cubics. */
+    Wavetable::Interpolation waveletInterpolation = Wavetable::Interpolation::linear;
+    Wavetable::Interpolation windowInterpolation  = Wavetable::Interpolation::linear;
+    int   masking = 0;
+
+    /* bit i of maskingPattern is pulse i, a maskingPatternLength of 0 masks at random instead. */
+    juce::uint32 maskingPattern = 0;
+    int   maskingPatternLength = 0;
+    int   maskingSeed = 1;
+    bool  fixedPointPhase = false;
+
+    /*
+    * the most the voices may oversample (1 off, 2, 4 or 8) and the fraction of the oversampled rate
+    * the pulsar's highest frequency has to pass before they do. Any setting above 1 adds
+    * OversamplingDecimator::latencySamples of delay, at every factor.
+    */
+    int   oversampling = 1;
+    float oversamplingThreshold = 0.45f;
+
+    /*
+    * cloud mode, see PulsaretCloud. A density above 0 (grains per second) plays the pulsarets as grains
+    * at random onsets instead of the pulse train, the spread varies each grain's formant (in octaves)
+    * and the width pans them (0 centre, 1 anywhere). Cloud voices are never oversampled.
+    */
+    float cloudDensity = 0.0f;
+    float cloudSpread = 0.0f, cloudWidth = 0.0f;
+
+    /*
+    * see PanMatrix. Off, every output channel gets the whole voice. On, the pulsarets are spread over
+    * the outputs around pan (0 to 1), panSpread 1 spaces them across the whole line or ring of speakers.
+    */
+    bool  panning = false;
+    float pan = 0.5f, panSpread = 0.0f;
+
+    /*
+    * tables used instead of the sine carriers and the windowShape window, null for the built in ones.
+    * Not set by the setters, SynthAudioSource fills them in on the audio thread from its TableBuilder.
+    */
+    const WavetableMipmap* carrierTable = nullptr;
+    const juce::AudioSampleBuffer* windowTable = nullptr;
+
+    /* the TableSet's generation, 0 before the first, see Pulsar::setWaveletTable. */
+    juce::uint32 tableGeneration = 0;
+    float attack = 0.5f, decay = 0.5f, sustain = 0.5f, release = 0.5f;
+};
+
+/*
+* Hands PulsarParameters from one writer thread (the gui) to one reader thread (audio) without locks.
+* A triple buffer, the writer and reader each own a slot and swap theirs with the spare one.
+* The reader always sees a complete snapshot, never half of one update and half of the next.
+*/
+class PulsarParameterStore
+{
+public:
+    PulsarParameterStore();
+    ~PulsarParameterStore();
+
+    /* writer thread. */
+    void publish(const PulsarParameters& parameters);
+
+    /* reader thread, picks up the latest snapshot. returns false if nothing has changed since the last call. */
+    bool update();
+    const PulsarParameters& get() const;
+private:
+    static constexpr int newDataFlag = 4;
+
+    std::array<PulsarParameters, 3> buffers;
+    int writeIndex = 0, readIndex = 2;
+
+    /* index of the spare slot, plus newDataFlag if the writer has filled it since the reader last looked. */
+    std::atomic<int> spare { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PulsarParameterStore)
+};
@@ -0,0 +1,128 @@
+#include "PulsarSynthesiser.h"
+
+PulsarSynthesiser::PulsarSynthesiser()
+{
+}
+
+PulsarSynthesiser::~PulsarSynthesiser()
+{
+}
+
+void PulsarSynthesiser::setNumRenderThreads(int numThreads)
+{
+    numRenderThreads = juce::jmax(0, numThreads);
+    rebuildRenderPool();
+}
+
+int PulsarSynthesiser::getNumRenderThreads() const
+{
+    return numRenderThreads;
+}
+
+void PulsarSynthesiser::prepareToRender(int numChannels, int maxBlockSize)
+{
+    numRenderChannels = numChannels;
+    maxRenderBlockSize = maxBlockSize;
+    rebuildRenderPool();
+}
+
+void PulsarSynthesiser::voicesChanged()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        activeVoices.ensureStorageAllocated(voices.size());
+        voiceSeconds.resize(voices.size());
+        timedVoices.clearQuick();
+
+        for (auto* voice : voices)
+            timedVoices.add(dynamic_cast<TimedSynthesiserVoice*>(voice));
+    }
+
+    if (numRenderThreads > 0 && voices.size() != numPoolVoices)
+        rebuildRenderPool();
+}
+
+/*
+* starting threads and allocating the scratch buffers happens before the lock, the audio thread is only
+* kept out of renderVoices for the swap. The old pool's threads are stopped after the lock is released.
+*/
+void PulsarSynthesiser::rebuildRenderPool()
+{
+    std::unique_ptr<VoiceRenderPool> newPool;
+    numPoolVoices = voices.size();
+
+    if (numRenderThreads > 0 && maxRenderBlockSize > 0)
+    {
+        newPool = std::make_unique<VoiceRenderPool>();
+        newPool->setNumWorkers(numRenderThreads);
+        newPool->prepare(numRenderChannels, maxRenderBlockSize, numPoolVoices);
+    }
+
+    {
+        const juce::ScopedLock sl(lock);
+        std::swap(renderPool, newPool);
+    }
+}
+
+void PulsarSynthesiser::renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    activeVoices.clearQuick();
+
+    for (auto* voice : voices)
+    {
+        if (voice->isVoiceActive())
+            activeVoices.add(voice);
+    }
+
+    if (!(activeVoices.size() > 1 && renderPool != nullptr
+          && renderPool->render(activeVoices.getRawDataPointer(), activeVoices.size(), outputAudio, startSample, numSamples)))
+    {
+        for (auto* voice : activeVoices)
+            voice->renderNextBlock(outputAudio, startSample, numSamples);
+    }
+
+    collectVoiceTimes(renderPool != nullptr ? renderPool->getAndResetNumLateWaits() : 0);
+}
+
+/* a block is rendered in sub blocks, so a voice's time is summed over them before it counts towards the slowest. */
+void PulsarSynthesiser::collectVoiceTimes(int numLateWaits)
+{
+    if (voiceTimesTaken)
+    {
+        voiceSeconds.fill(0.0);
+        voiceTimes = {};
+        voiceTimesTaken = false;
+    }
+
+    voiceTimes.numLateWaits += numLateWaits;
+
+    for (int i = 0; i < juce::jmin(voices.size(), timedVoices.size()); ++i)
+    {
+        auto* voice = timedVoices.getUnchecked(i);
+
+        if (voice == nullptr || voice != voices.getUnchecked(i))
+            continue;
+
+        /* a voice that finished during the block still took time. */
+        auto seconds = voice->getAndResetRenderSeconds();
+
+        if (seconds <= 0.0)
+            continue;
+
+        auto& sum = voiceSeconds.getReference(i);
+
+        if (sum <= 0.0)
+            ++voiceTimes.numActiveVoices;
+
+        sum += seconds;
+        voiceTimes.maxVoiceSeconds = juce::jmax(voiceTimes.maxVoiceSeconds, sum);
+        voiceTimes.totalVoiceSeconds += seconds;
+    }
+}
+
+VoiceTimes PulsarSynthesiser::getAndResetVoiceTimes()
+{
+    auto times = voiceTimesTaken ? VoiceTimes() : voiceTimes;
+    voiceTimesTaken = true;
+    return times;
+}
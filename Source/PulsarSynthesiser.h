@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VoiceRenderPool.h"
+
+/* a voice that times its own rendering, PulsarSynthesiser collects the times. */
+class TimedSynthesiserVoice : public juce::SynthesiserVoice
+{
+public:
+    /* time spent rendering since the last call, on whichever thread rendered it. */
+    virtual double getAndResetRenderSeconds() = 0;
+};
+
+/* the voices' render times over one block, see BlockTiming. */
+struct VoiceTimes
+{
+    int numActiveVoices = 0;
+    double maxVoiceSeconds = 0.0;
+    double totalVoiceSeconds = 0.0;
+
+    /* renders that waited on a render thread past VoiceRenderPool::maxWaitMicroseconds. */
+    int numLateWaits = 0;
+};
+
+/*
+* juce::Synthesiser renders its voices one after another on the audio thread.
+* This one hands the active voices to a VoiceRenderPool when there is more than one of them.
+*/
+class PulsarSynthesiser : public juce::Synthesiser
+{
+public:
+    PulsarSynthesiser();
+    ~PulsarSynthesiser() override;
+
+    /*
+    * number of extra threads to render voices on, 0 renders everything on the audio thread.
+    * These three build a new pool, off the lock, and only take the lock to swap it in.
+    */
+    void setNumRenderThreads(int numThreads);
+    int getNumRenderThreads() const;
+    void prepareToRender(int numChannels, int maxBlockSize);
+
+    /* call after adding or removing voices, so rendering never has to allocate. */
+    void voicesChanged();
+
+    /*
+    * audio thread, once per block after rendering it. The times are collected while the voices render,
+    * under the lock they render under, so this takes no lock of its own.
+    */
+    VoiceTimes getAndResetVoiceTimes();
+protected:
+    using juce::Synthesiser::renderVoices;
+    void renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+private:
+    void rebuildRenderPool();
+    void collectVoiceTimes(int numLateWaits);
+
+    /* the pool's settings belong to the thread configuring the synth, the pool itself to the audio thread. */
+    int numRenderThreads = 0, numRenderChannels = 2, maxRenderBlockSize = 0, numPoolVoices = 0;
+    std::unique_ptr<VoiceRenderPool> renderPool;
+    juce::Array<juce::SynthesiserVoice*> activeVoices;
+
+    /* each voice's seconds so far this block, by its place in voices, cleared on the first render of the next. */
+    juce::Array<double> voiceSeconds;
+
+    /*
+    * voices cast once in voicesChanged, nullptr for voices that are not timed. An entry is only used
+    * while voices still holds it in the same place, so a voice removed before voicesChanged is skipped.
+    */
+    juce::Array<TimedSynthesiserVoice*> timedVoices;
+    VoiceTimes voiceTimes;
+    bool voiceTimesTaken = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PulsarSynthesiser)
+};
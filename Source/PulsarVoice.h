@@ -0,0 +1,430 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Pulsar.h"
+#include "HalfbandDecimator.h"
+#include "PulsaretCloud.h"
+#include "PanMatrix.h"
+#include "WavetableBank.h"
+#include "PulsarParameters.h"
+#include "RenderTelemetry.h"
+#include "PulsarSynthesiser.h"
+
+//==============================================================================
+/*
+    PulsarSound is a passive class that describes the sound to a Synthesiser object.
+    The audio rendering is done by the SynthesiserVoice class.
+
+    PulsarSound may choose which midinotes and channels trigger the voice.
+
+    The wavelet tables are shared between voices through WavetableBank, the windows are WindowTables constants.
+*/
+
+struct PulsarSound : public juce::SynthesiserSound
+{
+    PulsarSound()
+    {
+    };
+
+    bool appliesToNote(int) override { return true; }
+    bool appliesToChannel(int) override { return true; }
+};
+
+//==============================================================================
+// A voice plays a single sound at a time but a Synthesiser can hold an array of voices.
+struct PulsarVoice : public TimedSynthesiserVoice
+{
+    /*
+    * parametersToUse is the audio thread's snapshot, owned by SynthAudioSource and
+    * only changed between the sub blocks it splits each block into, never while a voice renders.
+    * voiceNumber is added to the masking seed so voices do not mask in lockstep.
+    */
+    PulsarVoice(const PulsarParameters& parametersToUse, int voiceNumberToUse)
+        : parameters(parametersToUse),
+        voiceNumber(voiceNumberToUse)
+    {
+        adsr.setSampleRate(getSampleRate());
+        /* the sine lives in the shared bank and the window is compiled in, the voice only holds phase state. */
+        sine = &bank->getMipmap(WavetableBank::Shape::sine);
+        _pulsar = std::make_unique<Pulsar>(*sine, parameters.windowShape);
+        cloud = std::make_unique<PulsaretCloud>(*sine, parameters.windowShape);
+
+        for (auto& decimator : decimators)
+            decimator.prepare(Pulsar::blockSize);
+
+        for (size_t i = 0; i < waveletBuffers.size(); ++i)
+            waveletPointers[i] = waveletBuffers[i].data();
+    };
+
+    /*
+    * the sample rate is not known in the constructor, so pass it on here.
+    * Called from prepareToPlay and when the voice is added, never from the audio thread, so the grain pool is allocated here.
+    */
+    void setCurrentPlaybackSampleRate(double newRate) override
+    {
+        juce::SynthesiserVoice::setCurrentPlaybackSampleRate(newRate);
+
+        if (newRate > 0.0)
+        {
+            adsr.setSampleRate(newRate);
+            _pulsar->setSampleRate(newRate * getOversamplingFactor());
+            cloud->prepare(newRate);
+        }
+    }
+
+    /* In this case there is only one sound, so returns true if not a nullptr. */
+    bool canPlaySound(juce::SynthesiserSound* sound) override
+    {
+        /* 
+        * dynamic cast accesses the custom SynthesiserSound struct, rather than the base class.
+        * so check if sound is not a null pointer and then return true so this voice can play a sound.
+        */
+        return dynamic_cast <PulsarSound*> (sound) != nullptr;
+    }
+
+    void startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound*, int /*currentPitchWheelPosition*/)
+    {
+        /* edit this to spread notes over octave (seee the wavetable tutorial) */
+        auto cyclesPerSecond = juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber);
+        cyclesPerSample = (float)cyclesPerSecond / (float)getSampleRate();
+
+        /*
+        * calculate 12th root equal tempered scale.
+        * there is a midi note to Hz juce function but I want to modify the conversion to include other scales.
+        */
+        frequency = 440.0 * pow(2.0, (midiNoteNumber - 69.0) / 12.0);
+
+        level = velocity * 0.5f;
+        adsr.noteOn();
+        
+        /* a new note starts on the current parameters rather than gliding from the last note's. */
+        if (parameters.keyboardControl)
+        {
+            _pulsar->setFundamental((float)frequency, false);
+        } else 
+        {
+            _pulsar->setFundamental(parameters.fundamental, false);
+        }
+        
+        _pulsar->setPeriod(parameters.period, parameters.periodSpread, false);
+        _pulsar->setFormant(parameters.formant, false);
+        _pulsar->setIndex(parameters.index, false);
+        _pulsar->setStochasticMasking(parameters.masking);
+        cloud->reset();
+    }
+
+    void stopNote(float /*velocity*/, bool)
+    {
+        adsr.noteOff();
+    }
+
+    // pure virtual functions must be initialised.
+    void pitchWheelMoved(int)      override {};
+    void controllerMoved(int, int) override {};
+
+    // renderNextBlock now uses an adsr.
+    void renderNextBlock(juce::AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override
+    {
+
+        /* amplitde envelope params */
+        amplitudeParameters.attack  = parameters.attack;
+        amplitudeParameters.decay   = parameters.decay;
+        amplitudeParameters.sustain = parameters.sustain;
+        amplitudeParameters.release = parameters.release;
+        
+        adsr.setParameters(amplitudeParameters);
+
+        auto startTicks = RenderTelemetry::getTicks();
+
+        if (parameters.cloudDensity > 0.0f)
+        {
+            renderCloudBlock(outputBuffer, startSample, numSamples);
+        }
+        else
+        {
+            /* leaving cloud mode, the grains would otherwise carry on where they were if it came back. */
+            cloud->reset();
+            renderPulsarBlock(outputBuffer, startSample, numSamples);
+        }
+
+        renderSeconds += RenderTelemetry::ticksToSeconds(RenderTelemetry::getTicks() - startTicks);
+    }
+
+    /* time spent rendering since the last call, on whichever thread rendered it. */
+    double getAndResetRenderSeconds() override
+    {
+        auto seconds = renderSeconds;
+        renderSeconds = 0.0;
+        return seconds;
+    }
+
+    /*
+    * the new values are set once per block, the pulsar glides to them itself.
+    * The keyboard sets the fundamental directly, so it does not glide between notes.
+    */
+    void renderPulsarBlock(juce::AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
+    {
+        if (parameters.keyboardControl)
+            _pulsar->setFundamental((float)frequency, false);
+        else
+            _pulsar->setFundamental(parameters.fundamental);
+
+        _pulsar->setPeriod(parameters.period, parameters.periodSpread);
+        _pulsar->setFormant(parameters.formant);
+        _pulsar->setIndex(parameters.index);
+        _pulsar->setModulation(parameters.routing, parameters.phaseModulation ? Pulsar::Modulation::phase
+                                                                              : Pulsar::Modulation::frequency);
+        _pulsar->setModulatorRatios(parameters.ratioOne, parameters.ratioTwo);
+        _pulsar->setFeedback(parameters.feedback);
+        _pulsar->setNumWavelets(parameters.numPulsarets);
+        _pulsar->setWaveletInterpolation(parameters.waveletInterpolation);
+        _pulsar->setWindowInterpolation(parameters.windowInterpolation);
+        _pulsar->setWaveletTable(parameters.carrierTable != nullptr ? *parameters.carrierTable : *sine, parameters.tableGeneration);
+
+        if (parameters.windowTable != nullptr)
+            _pulsar->setWindowTable(*parameters.windowTable);
+        else
+            _pulsar->setWindowShape(parameters.windowShape);
+
+        _pulsar->setStochasticMasking(parameters.masking);
+        _pulsar->setMaskingPattern(parameters.maskingPattern, parameters.maskingPatternLength);
+        _pulsar->setMaskingSeed((juce::uint64)(juce::uint32)parameters.maskingSeed + (juce::uint64)voiceNumber);
+        _pulsar->setPhaseMode(parameters.fixedPointPhase ? Pulsar::PhaseMode::fixedPoint
+                                                         : Pulsar::PhaseMode::floatingPoint);
+        updateOversampling();
+
+        /*
+        * the pulsarets are only rendered apart when they sit in different places,
+        * an oversampled voice has one decimator so it is panned as a whole, at parameters.pan.
+        */
+        auto numWavelets = _pulsar->getNumWavelets();
+        auto numChannels = juce::jmin(outputBuffer.getNumChannels(), PanMatrix::maxChannels);
+        panMatrix.update(numChannels, numWavelets, parameters.panning, parameters.pan, parameters.panSpread);
+        auto separate = !oversampling && !panMatrix.isUniform();
+
+        while (numSamples > 0)
+        {
+            auto numThisTime = juce::jmin(numSamples, Pulsar::blockSize);
+            auto numToMix = fillEnvelope(numThisTime);
+            setOutputPointers(outputBuffer, numChannels, startSample);
+
+            if (separate)
+            {
+                if (_pulsar->renderWaveletsSeparately(waveletPointers.data(), numThisTime))
+                {
+                    for (int i = 0; i < numWavelets; ++i)
+                    {
+                        juce::FloatVectorOperations::multiply(waveletPointers[(size_t)i], envelopeBuffer.data(), numToMix);
+                        panMatrix.addRow(i, waveletPointers[(size_t)i], outputPointers.data(), numToMix);
+                    }
+                }
+            }
+            else
+            {
+                if (oversampling)
+                    renderOversampled(numThisTime);
+                else
+                    _pulsar->renderBlock(renderBuffer.data(), numThisTime);
+
+                juce::FloatVectorOperations::multiply(renderBuffer.data(), envelopeBuffer.data(), numToMix);
+                panMatrix.addCentre(renderBuffer.data(), outputPointers.data(), numToMix);
+            }
+
+            if (!adsr.isActive())
+            {
+                clearCurrentNote();
+                return;
+            }
+
+            startSample += numThisTime;
+            numSamples -= numThisTime;
+        }
+    }
+
+    /*
+    * cloud mode, the grains take the pulsar's first pulsaret: the carrier at fundamental * period / formant
+    * and the window lasting formant / fundamental seconds. Each grain is panned, so the cloud is stereo,
+    * a mono output gets both sides. Grains still sounding when the note ends are cut with it.
+    */
+    void renderCloudBlock(juce::AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
+    {
+        /* a formant or fundamental of zero would give an infinite carrier or grain duration. */
+        auto fundamental = juce::jmax(minimumCloudParameter, parameters.keyboardControl ? (float)frequency : parameters.fundamental);
+        auto formant = juce::jmax(minimumCloudParameter, parameters.formant);
+
+        cloud->setDensity(parameters.cloudDensity);
+        cloud->setPulsaret(fundamental * parameters.period / formant, formant / fundamental);
+        cloud->setSpread(parameters.cloudSpread);
+        cloud->setWidth(parameters.cloudWidth);
+        cloud->setWaveletTable(parameters.carrierTable != nullptr ? *parameters.carrierTable : *sine, parameters.tableGeneration);
+
+        if (parameters.windowTable != nullptr)
+            cloud->setWindowTable(*parameters.windowTable);
+        else
+            cloud->setWindowShape(parameters.windowShape);
+
+        cloud->setInterpolation(parameters.waveletInterpolation, parameters.windowInterpolation);
+        cloud->setSeed((juce::uint64)(juce::uint32)parameters.maskingSeed + (juce::uint64)voiceNumber);
+
+        auto numChannels = outputBuffer.getNumChannels();
+
+        while (numSamples > 0)
+        {
+            auto numThisTime = juce::jmin(numSamples, Pulsar::blockSize);
+            auto numToMix = fillEnvelope(numThisTime);
+
+            juce::FloatVectorOperations::clear(renderBuffer.data(), numThisTime);
+            juce::FloatVectorOperations::clear(rightBuffer.data(), numThisTime);
+            cloud->renderBlock(renderBuffer.data(), rightBuffer.data(), numThisTime);
+
+            juce::FloatVectorOperations::multiply(renderBuffer.data(), envelopeBuffer.data(), numToMix);
+            juce::FloatVectorOperations::multiply(rightBuffer.data(), envelopeBuffer.data(), numToMix);
+
+            auto* left = outputBuffer.getWritePointer(0, startSample);
+            juce::FloatVectorOperations::add(left, renderBuffer.data(), numToMix);
+            juce::FloatVectorOperations::add(numChannels == 1 ? left : outputBuffer.getWritePointer(1, startSample),
+                                             rightBuffer.data(), numToMix);
+
+            if (!adsr.isActive())
+            {
+                clearCurrentNote();
+                cloud->reset();
+                return;
+            }
+
+            startSample += numThisTime;
+            numSamples -= numThisTime;
+        }
+    }
+
+private:
+    /*
+    * level times the adsr into envelopeBuffer, one value per sample.
+    * returns the number of samples up to and including the one the note ends on, numSamples if it carries on.
+    */
+    int fillEnvelope(int numSamples)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            envelopeBuffer[(size_t)n] = level * adsr.getNextSample();
+
+            if (!adsr.isActive())
+                return n + 1;
+        }
+
+        return numSamples;
+    }
+
+    void setOutputPointers(juce::AudioSampleBuffer& outputBuffer, int numChannels, int startSample)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            outputPointers[(size_t)channel] = outputBuffer.getWritePointer(channel, startSample);
+    }
+
+    int getOversamplingFactor() const
+    {
+        return oversampling ? decimators[currentDecimator].getFactor() : 1;
+    }
+
+    /*
+    * picks the smallest factor that keeps the pulsar's highest frequency under the threshold,
+    * a fraction of the oversampled rate. It only comes down again once well under the lower factor's limit.
+    * On a change the previous decimator is flushed and added in while the new one fills,
+    * both have the same delay so the two halves line up.
+    */
+    void updateOversampling()
+    {
+        auto maxFactor = juce::jlimit(1, OversamplingDecimator::maxFactor, juce::nextPowerOfTwo(parameters.oversampling));
+
+        if (maxFactor == 1)
+        {
+            if (oversampling)
+            {
+                oversampling = false;
+                _pulsar->changeSampleRate(getSampleRate());
+            }
+
+            return;
+        }
+
+        auto limit = (float)getSampleRate() * parameters.oversamplingThreshold;
+        auto highestFrequency = _pulsar->getHighestFrequency();
+        auto currentFactor = getOversamplingFactor();
+        auto factor = 1;
+
+        while (factor < maxFactor && highestFrequency > limit * (float)factor)
+            factor *= 2;
+
+        if (factor < currentFactor && highestFrequency > limit * (float)factor * hysteresis)
+            factor = currentFactor;
+
+        if (!oversampling)
+        {
+            /* nothing worth keeping in the decimators, start clean. */
+            oversampling = true;
+            decimators[currentDecimator].setFactor(factor);
+            fadeSamplesRemaining = 0;
+            _pulsar->changeSampleRate(getSampleRate() * factor);
+            return;
+        }
+
+        if (factor == currentFactor)
+            return;
+
+        currentDecimator = 1 - currentDecimator;
+        decimators[currentDecimator].setFactor(factor);
+        fadeSamplesRemaining = 2 * OversamplingDecimator::latencySamples;
+        _pulsar->changeSampleRate(getSampleRate() * factor);
+    }
+
+    void renderOversampled(int numSamples)
+    {
+        auto& decimator = decimators[currentDecimator];
+
+        _pulsar->renderBlock(oversampledBuffer.data(), numSamples * decimator.getFactor());
+        decimator.process(oversampledBuffer.data(), renderBuffer.data(), numSamples);
+
+        if (fadeSamplesRemaining > 0)
+        {
+            decimators[1 - currentDecimator].flush(fadeBuffer.data(), numSamples);
+            juce::FloatVectorOperations::add(renderBuffer.data(), fadeBuffer.data(), numSamples);
+            fadeSamplesRemaining -= numSamples;
+        }
+    }
+
+    const PulsarParameters& parameters;
+    int voiceNumber;
+    juce::ADSR::Parameters amplitudeParameters { 0.1f, 0.1f, 0.5f, 0.1f };
+    juce::ADSR adsr;
+    juce::SharedResourcePointer<WavetableBank> bank;
+
+    /* fetched once, the bank's lock is not for the audio thread. */
+    const WavetableMipmap* sine = nullptr;
+    std::unique_ptr<Pulsar> _pulsar;
+    std::unique_ptr<PulsaretCloud> cloud;
+    alignas (16) std::array<float, Pulsar::blockSize> renderBuffer {}, envelopeBuffer {};
+
+    /* each pulsaret's chunk when they are panned apart, and where the current chunk goes in each channel. */
+    PanMatrix panMatrix;
+    alignas (16) std::array<std::array<float, Pulsar::blockSize>, Pulsar::maxWavelets> waveletBuffers {};
+    std::array<float*, Pulsar::maxWavelets> waveletPointers {};
+    std::array<float*, PanMatrix::maxChannels> outputPointers {};
+
+    /* the current decimator and the one being flushed after a change of factor. */
+    static constexpr float hysteresis = 0.8f;
+    OversamplingDecimator decimators[2];
+    int currentDecimator = 0;
+    int fadeSamplesRemaining = 0;
+    bool oversampling = false;
+    alignas (16) std::array<float, Pulsar::blockSize * OversamplingDecimator::maxFactor> oversampledBuffer {};
+    alignas (16) std::array<float, Pulsar::blockSize> fadeBuffer {};
+
+    static constexpr float minimumCloudParameter = 0.01f;
+
+    /* the cloud's right channel, its left goes in renderBuffer. */
+    alignas (16) std::array<float, Pulsar::blockSize> rightBuffer {};
+    float level = 0.0f;
+    float cyclesPerSample = 0.0f;
+    double renderSeconds = 0.0;
+    double frequency = 0.0;
+};
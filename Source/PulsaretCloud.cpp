@@ -0,0 +1,261 @@
+#include "PulsaretCloud.h"
+
+PulsaretCloud::PulsaretCloud(const WavetableMipmap& waveTableToUse, WindowTables::Shape windowShape)
+    : carrier(waveTableToUse),
+    window(WindowTables::getTable(windowShape), WindowTables::tableSize),
+    carrierTable(&waveTableToUse),
+    windowPhaseLimit((float)(WindowTables::tableSize - 1) / (float)WindowTables::tableSize)
+{
+    window.setPeriodic(false);
+
+    /* the first onset comes after a random gap, like every other. */
+    onsetCountdown = nextOnsetInterval();
+}
+
+PulsaretCloud::~PulsaretCloud()
+{
+}
+
+void PulsaretCloud::prepare(double newSampleRate, int maxGrains)
+{
+    sampleRate = newSampleRate;
+
+    grains.resize((size_t)maxGrains);
+    freeGrains.resize((size_t)maxGrains);
+    activeGrains.resize((size_t)maxGrains);
+
+    numActive = 0;
+    numFree = maxGrains;
+
+    /* handed out from the top of the stack, so grain 0 goes first. */
+    for (int i = 0; i < numFree; ++i)
+        freeGrains[(size_t)i] = numFree - 1 - i;
+}
+
+/* only touches the sounding grains, so it costs nothing once the cloud is quiet. */
+void PulsaretCloud::reset()
+{
+    while (numActive > 0)
+        freeGrains[(size_t)numFree++] = activeGrains[(size_t)--numActive];
+}
+
+void PulsaretCloud::setDensity(float grainsPerSecond)
+{
+    density = juce::jmax(0.0f, grainsPerSecond);
+}
+
+void PulsaretCloud::setPulsaret(float newFrequency, float durationSeconds)
+{
+    frequency = newFrequency;
+    duration = durationSeconds;
+}
+
+void PulsaretCloud::setSpread(float octaves)
+{
+    spread = juce::jmax(0.0f, octaves);
+}
+
+void PulsaretCloud::setWidth(float newWidth)
+{
+    width = juce::jlimit(0.0f, 1.0f, newWidth);
+}
+
+void PulsaretCloud::setWindowShape(WindowTables::Shape newShape)
+{
+    window.setTable(WindowTables::getTable(newShape), WindowTables::tableSize);
+    windowPhaseLimit = (float)(WindowTables::tableSize - 1) / (float)WindowTables::tableSize;
+}
+
+void PulsaretCloud::setWindowTable(const juce::AudioSampleBuffer& windowTableToUse)
+{
+    auto frameSize = windowTableToUse.getNumSamples() - 1;
+
+    window.setTable(windowTableToUse.getReadPointer(0), frameSize);
+    windowPhaseLimit = (float)(frameSize - 1) / (float)frameSize;
+}
+
+void PulsaretCloud::setWaveletTable(const WavetableMipmap& waveTableToUse, juce::uint32 tableGeneration)
+{
+    if (&waveTableToUse == carrierTable && tableGeneration == carrierTableGeneration)
+        return;
+
+    carrierTable = &waveTableToUse;
+    carrierTableGeneration = tableGeneration;
+    carrier.setMipmap(waveTableToUse);
+}
+
+void PulsaretCloud::setInterpolation(Wavetable::Interpolation waveletInterpolation, Wavetable::Interpolation windowInterpolation)
+{
+    carrier.setInterpolation(waveletInterpolation);
+    window.setInterpolation(windowInterpolation);
+}
+
+void PulsaretCloud::setSeed(juce::uint64 newSeed)
+{
+    if (newSeed == seed)
+        return;
+
+    seed = newSeed;
+    random.setSeed((juce::int64)seed);
+    onsetCountdown = nextOnsetInterval();
+}
+
+int PulsaretCloud::getNumActiveGrains() const
+{
+    return numActive;
+}
+
+juce::int64 PulsaretCloud::getNumGrainsStarted() const
+{
+    return grainsStarted;
+}
+
+juce::int64 PulsaretCloud::getNumGrainsDropped() const
+{
+    return grainsDropped;
+}
+
+void PulsaretCloud::renderBlock(float* left, float* right, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        auto numThisTime = juce::jmin(numSamples, blockSize);
+
+        renderChunk(left, right, numThisTime);
+
+        left       += numThisTime;
+        right      += numThisTime;
+        numSamples -= numThisTime;
+    }
+}
+
+/*
+* the grains starting in this chunk are taken from the pool first, then every sounding grain is rendered.
+* A finished grain goes back on the free list and the last active grain takes its place.
+*/
+void PulsaretCloud::renderChunk(float* left, float* right, int numSamples)
+{
+    startGrains(numSamples);
+
+    for (int i = 0; i < numActive;)
+    {
+        auto index = activeGrains[(size_t)i];
+        auto& grain = grains[(size_t)index];
+
+        renderGrain(grain, left, right, numSamples);
+
+        if (grain.samplesRemaining > 0)
+        {
+            ++i;
+            continue;
+        }
+
+        freeGrains[(size_t)numFree++] = index;
+        activeGrains[(size_t)i] = activeGrains[(size_t)--numActive];
+    }
+}
+
+/*
+* onsetCountdown is kept in units of the average gap (an exponential with a mean of 1) rather than in samples,
+* so a change of density moves the next onset straight away instead of after the gap already drawn.
+*/
+void PulsaretCloud::startGrains(int numSamples)
+{
+    auto onsetsPerSample = (double)density / sampleRate;
+
+    if (onsetsPerSample <= 0.0)
+        return;
+
+    auto position = 0.0;
+
+    for (;;)
+    {
+        auto samplesUntil = onsetCountdown / onsetsPerSample;
+
+        if (position + samplesUntil >= (double)numSamples)
+        {
+            onsetCountdown -= ((double)numSamples - position) * onsetsPerSample;
+            return;
+        }
+
+        position += samplesUntil;
+        startGrain((int)position);
+        onsetCountdown = nextOnsetInterval();
+    }
+}
+
+void PulsaretCloud::startGrain(int offset)
+{
+    /* drawn whether or not the grain fits, so a full pool does not change the grains after it. */
+    auto formantScale = std::exp2(nextOctaves());
+    auto pan = 0.5f + width * (random.nextFloat() - 0.5f);
+    ++grainsStarted;
+
+    if (numFree == 0)
+    {
+        ++grainsDropped;
+        return;
+    }
+
+    auto index = freeGrains[(size_t)--numFree];
+    activeGrains[(size_t)numActive++] = index;
+    auto& grain = grains[(size_t)index];
+
+    /* as in Pulsar, a higher formant raises the carrier and shortens the window by the same ratio. */
+    auto cyclesPerSample = juce::jlimit(0.0f, 0.5f, frequency * formantScale / (float)sampleRate);
+    auto numSamples = juce::jmax(1, juce::roundToInt((double)duration / formantScale * sampleRate));
+
+    /* keeps the level of the cloud about the same however many grains overlap on average. */
+    auto gain = 1.0f / std::sqrt(1.0f + density * duration);
+
+    grain.carrierPhase           = 0;
+    grain.carrierIncrement       = (juce::uint32)((double)cyclesPerSample * 4294967296.0);
+    grain.carrierCyclesPerSample = cyclesPerSample;
+    grain.windowPhase            = 0;
+    grain.windowIncrement        = (juce::uint32)((double)windowPhaseLimit * 4294967296.0 / (double)numSamples);
+    grain.gainLeft               = gain * std::cos(pan * juce::MathConstants<float>::halfPi);
+    grain.gainRight              = gain * std::sin(pan * juce::MathConstants<float>::halfPi);
+    grain.offset                 = offset;
+    grain.samplesRemaining       = numSamples;
+}
+
+/*
+* the phases are worked out from the grain's start phase rather than accumulated,
+* so there is no dependency from one sample to the next and the loops vectorise.
+*/
+void PulsaretCloud::renderGrain(Grain& grain, float* left, float* right, int numSamples)
+{
+    auto numToRender = juce::jmin(numSamples - grain.offset, grain.samplesRemaining);
+
+    for (int n = 0; n < numToRender; ++n)
+        phaseBuffer[(size_t)n] = grain.carrierPhase + (juce::uint32)n * grain.carrierIncrement;
+
+    carrier.setPhaseIncrement(grain.carrierCyclesPerSample);
+    carrier.processBlock(phaseBuffer.data(), carrierBuffer.data(), numToRender);
+
+    for (int n = 0; n < numToRender; ++n)
+        phaseBuffer[(size_t)n] = grain.windowPhase + (juce::uint32)n * grain.windowIncrement;
+
+    window.processBlock(phaseBuffer.data(), windowBuffer.data(), numToRender);
+
+    juce::FloatVectorOperations::multiply        (carrierBuffer.data(), windowBuffer.data(), numToRender);
+    juce::FloatVectorOperations::addWithMultiply (left  + grain.offset, carrierBuffer.data(), grain.gainLeft,  numToRender);
+    juce::FloatVectorOperations::addWithMultiply (right + grain.offset, carrierBuffer.data(), grain.gainRight, numToRender);
+
+    grain.carrierPhase     += (juce::uint32)numToRender * grain.carrierIncrement;
+    grain.windowPhase      += (juce::uint32)numToRender * grain.windowIncrement;
+    grain.samplesRemaining -= numToRender;
+    grain.offset            = 0;
+}
+
+/* evenly between -spread and +spread. */
+float PulsaretCloud::nextOctaves()
+{
+    return spread * (2.0f * random.nextFloat() - 1.0f);
+}
+
+/* the gap to the next onset in units of the average gap, exponentially distributed. */
+float PulsaretCloud::nextOnsetInterval()
+{
+    return -std::log(1.0f - random.nextFloat());
+}
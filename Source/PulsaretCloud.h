@@ -0,0 +1,110 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Wavetable.h"
+#include "WindowTables.h"
+
+/*
+* Cloud mode, the pulsarets are released from the pulse train and scheduled on their own as grains
+* (see Roads, Microsound 3, asynchronous granular synthesis). Onsets are random at an average density,
+* each grain keeps the frequency, duration and pan it was given when it started, so grains overlap freely.
+*
+* The grains live in a fixed pool allocated by prepare, with a free list of the unused ones,
+* so starting and ending a grain on the audio thread never touches the heap.
+* A grain that starts while the pool is full is dropped and counted.
+*/
+class PulsaretCloud
+{
+public:
+    PulsaretCloud(const WavetableMipmap& waveTableToUse, WindowTables::Shape windowShape = WindowTables::Shape::hann);
+    ~PulsaretCloud();
+
+    /* allocates the pool, not from the audio thread. Every grain is ended. */
+    void prepare(double sampleRate, int maxGrains = defaultMaxGrains);
+
+    /* ends every grain, keeps the next onset. */
+    void reset();
+
+    /* average grains per second, the onsets are a poisson process so the gaps between them are random. */
+    void setDensity(float grainsPerSecond);
+
+    /* the carrier frequency in Hz and window length in seconds a grain gets before it is spread. */
+    void setPulsaret(float frequency, float durationSeconds);
+
+    /*
+    * each grain's formant is moved by up to this many octaves either way, like Pulsar's formant
+    * a higher carrier comes with a shorter window.
+    */
+    void setSpread(float octaves);
+
+    /* 0 puts every grain in the centre, 1 pans them anywhere between left and right. */
+    void setWidth(float newWidth);
+
+    void setWindowShape(WindowTables::Shape newShape);
+
+    /* as Pulsar's, a window or carrier from a MappedWavetableBank. Nothing is copied, grains already started change too. */
+    void setWindowTable(const juce::AudioSampleBuffer& windowTableToUse);
+    void setWaveletTable(const WavetableMipmap& waveTableToUse, juce::uint32 tableGeneration = 0);
+
+    void setInterpolation(Wavetable::Interpolation waveletInterpolation, Wavetable::Interpolation windowInterpolation);
+
+    /* the same seed gives the same cloud, does nothing if the seed has not changed. */
+    void setSeed(juce::uint64 newSeed);
+
+    /* adds numSamples of the cloud to left and right. */
+    void renderBlock(float* left, float* right, int numSamples);
+
+    int getNumActiveGrains() const;
+
+    /* grains started so far, and of those the ones dropped because the pool was full. */
+    juce::int64 getNumGrainsStarted() const;
+    juce::int64 getNumGrainsDropped() const;
+
+    /* renderBlock works through the output in chunks of this size. */
+    static constexpr int blockSize = 64;
+    static constexpr int defaultMaxGrains = 1024;
+private:
+    /* everything a grain needs, phases are fixed point with 2^32 one cycle. */
+    struct Grain
+    {
+        juce::uint32 carrierPhase, carrierIncrement;
+        juce::uint32 windowPhase, windowIncrement;
+        float carrierCyclesPerSample;
+        float gainLeft, gainRight;
+        int offset, samplesRemaining;
+    };
+
+    void renderChunk(float* left, float* right, int numSamples);
+    void startGrains(int numSamples);
+    void startGrain(int offset);
+    void renderGrain(Grain& grain, float* left, float* right, int numSamples);
+    float nextOctaves();
+    float nextOnsetInterval();
+
+    Wavetable carrier, window;
+    const WavetableMipmap* carrierTable;
+    juce::uint32 carrierTableGeneration = 0;
+    float windowPhaseLimit;
+
+    /* the pool, the indices of its free grains (a stack) and of the sounding ones. */
+    std::vector<Grain> grains;
+    std::vector<int> freeGrains, activeGrains;
+    int numFree = 0, numActive = 0;
+
+    double sampleRate = 44100.0;
+    float density = 0.0f, frequency = 440.0f, duration = 0.01f;
+    float spread = 0.0f, width = 0.0f;
+
+    /* what is left of the gap to the next onset, in units of the average gap, see startGrains. */
+    double onsetCountdown = 0.0;
+    juce::int64 grainsStarted = 0, grainsDropped = 0;
+
+    juce::uint64 seed = 0;
+    juce::Random random { 0 };
+
+    /* scratch buffers, one chunk long. */
+    alignas (16) std::array<juce::uint32, blockSize> phaseBuffer {};
+    alignas (16) std::array<float, blockSize> carrierBuffer {}, windowBuffer {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PulsaretCloud)
+};
@@ -0,0 +1,74 @@
+#include "PulseMask.h"
+
+namespace
+{
+    /* PCG32 constants, the increment must be odd. */
+    constexpr juce::uint64 multiplier = 6364136223846793005ull;
+    constexpr juce::uint64 increment  = 1442695040888963407ull;
+}
+
+PulseMask::PulseMask()
+{
+    state = seed + increment;
+    nextRandom();
+}
+
+PulseMask::~PulseMask()
+{
+}
+
+void PulseMask::setSeed(juce::uint64 newSeed)
+{
+    if (newSeed == seed)
+        return;
+
+    seed = newSeed;
+    state = seed + increment;
+    nextRandom();
+    patternPosition = 0;
+}
+
+void PulseMask::setMaskingPercentage(int newMaskingPercentage)
+{
+    maskingPercentage = newMaskingPercentage;
+}
+
+void PulseMask::setPattern(juce::uint32 newPattern, int newLength)
+{
+    newLength = juce::jlimit(0, 32, newLength);
+
+    if (newPattern == pattern && newLength == patternLength)
+        return;
+
+    pattern = newPattern;
+    patternLength = newLength;
+    patternPosition = 0;
+}
+
+bool PulseMask::nextPulse()
+{
+    if (patternLength > 0)
+    {
+        auto sounds = ((pattern >> patternPosition) & 1u) != 0;
+        patternPosition = (patternPosition + 1) % patternLength;
+        return sounds;
+    }
+
+    if (maskingPercentage <= 0)
+        return true;
+
+    /* a number between 0 and 99 without a divide, the pulse sounds if it is not below the masking percentage. */
+    auto percent = (int)(((juce::uint64)nextRandom() * 100u) >> 32);
+    return percent >= maskingPercentage;
+}
+
+juce::uint32 PulseMask::nextRandom()
+{
+    auto previous = state;
+    state = previous * multiplier + increment;
+
+    auto xorShifted = (juce::uint32)(((previous >> 18u) ^ previous) >> 27u);
+    auto rotation = (juce::uint32)(previous >> 59u);
+
+    return (xorShifted >> rotation) | (xorShifted << ((32u - rotation) & 31u));
+}
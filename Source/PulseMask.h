@@ -0,0 +1,37 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+* Stochastic masking, decides once per pulse whether that pulse sounds.
+* A pulse is masked at random with a probability of maskingPercentage, or follows a repeating on/off pattern.
+* The random numbers come from a small PCG32 generator, the same seed gives the same masking on every run.
+*/
+class PulseMask
+{
+public:
+    PulseMask();
+    ~PulseMask();
+
+    /* restarts the generator and the pattern, does nothing if the seed has not changed. */
+    void setSeed(juce::uint64 newSeed);
+    void setMaskingPercentage(int newMaskingPercentage);
+
+    /*
+    * bit i of pattern is pulse i of the cycle, 1 sounds and 0 is masked, the pattern repeats every length pulses.
+    * a length of 0 goes back to random masking.
+    */
+    void setPattern(juce::uint32 newPattern, int newLength);
+
+    /* call at every pulse onset, returns true if the pulse sounds. */
+    bool nextPulse();
+private:
+    juce::uint32 nextRandom();
+
+    juce::uint64 seed = 0;
+    juce::uint64 state = 0;
+    int maskingPercentage = 0;
+
+    juce::uint32 pattern = 0;
+    int patternLength = 0, patternPosition = 0;
+};
@@ -0,0 +1,62 @@
+#include "PulseScheduler.h"
+
+PulseScheduler::PulseScheduler()
+{
+}
+
+PulseScheduler::~PulseScheduler()
+{
+}
+
+bool PulseScheduler::advance(juce::uint32 increment)
+{
+    auto previous = phase;
+    phase += increment;
+
+    /* the phase wrapped if it went backwards, a clock standing still never starts a pulse. */
+    return phase < previous;
+}
+
+int PulseScheduler::findOnsets(juce::uint32 increment, int numSamples, int* onsets)
+{
+    if (increment == 0)
+        return 0;
+
+    int numOnsets = 0;
+    int position = 0;
+
+    while (true)
+    {
+        /* the phase left before it wraps, in whole increments, is how many samples until the onset. */
+        auto samplesToWrap = ((juce::uint64)1 << 32) - phase;
+        auto samplesUntilOnset = (samplesToWrap + increment - 1) / increment;
+
+        if ((juce::uint64)(numSamples - position) < samplesUntilOnset)
+        {
+            phase += (juce::uint32)(numSamples - position) * increment;
+            return numOnsets;
+        }
+
+        position += (int)samplesUntilOnset;
+        phase += (juce::uint32)samplesUntilOnset * increment;
+        onsets[numOnsets++] = position - 1;
+    }
+}
+
+int PulseScheduler::findOnsets(const juce::uint32* increments, int numSamples, int* onsets)
+{
+    int numOnsets = 0;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        if (advance(increments[n]))
+            onsets[numOnsets++] = n;
+    }
+
+    return numOnsets;
+}
+
+void PulseScheduler::reset()
+{
+    phase = 0;
+}
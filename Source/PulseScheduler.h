@@ -0,0 +1,32 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+* Keeps the pulse clock, the phase that runs at the fundamental and starts a new pulse each time it wraps.
+* The phase is a 32 bit integer (2^32 is one cycle), so with a steady fundamental the sample a pulse
+* starts on is worked out directly instead of being tested for every sample.
+* The renderer splits its block at these onsets and handles resets only at the boundaries.
+*/
+class PulseScheduler
+{
+public:
+    PulseScheduler();
+    ~PulseScheduler();
+
+    /* advances by one sample, returns true if a pulse starts on it. */
+    bool advance(juce::uint32 increment);
+
+    /*
+    * advances by numSamples with a steady increment, writes the offset of each onset into onsets.
+    * returns the number of onsets, onsets must have room for numSamples of them.
+    */
+    int findOnsets(juce::uint32 increment, int numSamples, int* onsets);
+
+    /* the same for an increment that changes every sample, a gliding fundamental. */
+    int findOnsets(const juce::uint32* increments, int numSamples, int* onsets);
+
+    void reset();
+private:
+    juce::uint32 phase = 0;
+};
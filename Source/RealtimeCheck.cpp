@@ -0,0 +1,303 @@
+#include "RealtimeCheck.h"
+
+#if PULSAR_RT_CHECKS
+ #include <new>
+ #if JUCE_WINDOWS
+  #include <malloc.h>
+ #endif
+ #if JUCE_LINUX
+  #include <pthread.h>
+  #include <dlfcn.h>
+ #endif
+
+namespace
+{
+    constexpr int maxReports = 16;
+
+    /* sectionDepth is above 0 inside a section, reporting stops the report itself from being a violation. */
+    thread_local int sectionDepth = 0;
+    thread_local bool reporting = false;
+
+    std::atomic<int> mode { (int)RealtimeCheck::Mode::count };
+    std::atomic<int> numViolations { 0 };
+    std::atomic<int> numUncontendedLocks { 0 };
+
+    juce::SpinLock reportLock;
+
+    /* built on first use, outside any section, so it is never half constructed when a hook runs. */
+    juce::StringArray& getReports()
+    {
+        static juce::StringArray reports;
+        return reports;
+    }
+
+    bool isWatched()
+    {
+        return sectionDepth > 0 && !reporting;
+    }
+
+    /* everything this allocates is freed again before it returns. */
+    void writeReport(const char* what)
+    {
+        auto report = juce::String(what) + " on the audio thread\n" + juce::SystemStats::getStackBacktrace();
+        auto currentMode = (RealtimeCheck::Mode)mode.load();
+
+        {
+            const juce::SpinLock::ScopedLockType sl(reportLock);
+
+            if (getReports().size() < maxReports)
+                getReports().add(report);
+        }
+
+        if (currentMode != RealtimeCheck::Mode::count)
+            juce::Logger::outputDebugString(report);
+
+        if (currentMode == RealtimeCheck::Mode::trap)
+        {
+            jassertfalse;
+            std::abort();
+        }
+    }
+
+    /* the aligned operators below share these, so every aligned block is freed the way it was allocated. */
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        auto align = juce::jmax((std::size_t)alignment, sizeof(void*));
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size == 0 ? 1 : size, align);
+       #else
+        void* p = nullptr;
+        return posix_memalign(&p, align, size == 0 ? 1 : size) == 0 ? p : nullptr;
+       #endif
+    }
+
+    void freeAligned(void* p) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free(p);
+       #else
+        std::free(p);
+       #endif
+    }
+
+    void reportViolation(const char* what)
+    {
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+
+        /* the report allocates, which is fine now that the audio has already been put at risk. */
+        reporting = true;
+        writeReport(what);
+        reporting = false;
+    }
+}
+
+//==============================================================================
+RealtimeCheck::ScopedSection::ScopedSection()
+{
+    /* make sure the report storage exists before the first hook can want it. */
+    if (sectionDepth++ == 0 && !reporting)
+    {
+        reporting = true;
+        getReports();
+        reporting = false;
+    }
+}
+
+RealtimeCheck::ScopedSection::~ScopedSection()
+{
+    --sectionDepth;
+}
+
+//==============================================================================
+void* operator new(std::size_t size)
+{
+    if (isWatched())
+        reportViolation("operator new");
+
+    if (auto* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    if (isWatched())
+        reportViolation("operator new");
+
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p != nullptr && isWatched())
+        reportViolation("operator delete");
+
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+/* the aligned forms, which new uses for types aligned beyond what malloc guarantees. */
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (isWatched())
+        reportViolation("operator new");
+
+    if (auto* p = allocateAligned(size, alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    if (isWatched())
+        reportViolation("operator new");
+
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    if (p != nullptr && isWatched())
+        reportViolation("operator delete");
+
+    freeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    operator delete(p, alignment);
+}
+
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    operator delete(p, alignment);
+}
+
+ #if JUCE_LINUX
+/* the libc function this one hides, looked up the first time anything locks. */
+static int callRealMutexLock(pthread_mutex_t* mutex)
+{
+    using MutexLock = int (*)(pthread_mutex_t*);
+    static const auto realMutexLock = (MutexLock)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    return realMutexLock(mutex);
+}
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    if (isWatched())
+    {
+        if (pthread_mutex_trylock(mutex) == 0)
+        {
+            numUncontendedLocks.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+
+        reportViolation("blocking on a mutex");
+    }
+
+    return callRealMutexLock(mutex);
+}
+ #endif
+#endif
+
+//==============================================================================
+void RealtimeCheck::setMode(Mode newMode)
+{
+#if PULSAR_RT_CHECKS
+    mode = (int)newMode;
+#else
+    juce::ignoreUnused(newMode);
+#endif
+}
+
+int RealtimeCheck::getNumViolations()
+{
+#if PULSAR_RT_CHECKS
+    return numViolations.load();
+#else
+    return 0;
+#endif
+}
+
+int RealtimeCheck::getNumUncontendedLocks()
+{
+#if PULSAR_RT_CHECKS
+    return numUncontendedLocks.load();
+#else
+    return 0;
+#endif
+}
+
+juce::String RealtimeCheck::getReport()
+{
+#if PULSAR_RT_CHECKS
+    const juce::SpinLock::ScopedLockType sl(reportLock);
+    return juce::String(numViolations.load()) + " real time violations, "
+         + juce::String(numUncontendedLocks.load()) + " uncontended locks\n\n"
+         + getReports().joinIntoString("\n");
+#else
+    return "real time checks are off, build with PULSAR_RT_CHECKS=1";
+#endif
+}
+
+void RealtimeCheck::reset()
+{
+#if PULSAR_RT_CHECKS
+    const juce::SpinLock::ScopedLockType sl(reportLock);
+    getReports().clear();
+    numViolations = 0;
+    numUncontendedLocks = 0;
+#endif
+}
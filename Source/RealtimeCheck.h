@@ -0,0 +1,50 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+* Build with PULSAR_RT_CHECKS=1 (the Debug configurations of the app, PulsarRender and PulsarBench do)
+* to catch the audio thread doing something that can block it.
+* While a ScopedSection is alive on a thread, the global operator new and delete and, on Linux,
+* pthread_mutex_lock are watched. Allocating or freeing is a violation, a lock only if it is held by
+* another thread and would have blocked. An uncontended lock never reaches the kernel, those are only counted.
+* Each violation is counted and the first few are kept with the stack they happened on.
+*
+* With PULSAR_RT_CHECKS=0 ScopedSection is empty and nothing is hooked.
+*/
+#ifndef PULSAR_RT_CHECKS
+ #define PULSAR_RT_CHECKS 0
+#endif
+
+class RealtimeCheck
+{
+public:
+    enum class Mode
+    {
+        count,  /* count and keep the first reports. */
+        log,    /* also write each report to the log as it happens. */
+        trap    /* log the report then stop, so a debugger lands on the violation. */
+    };
+
+    static void setMode(Mode newMode);
+
+    static int getNumViolations();
+    static int getNumUncontendedLocks();
+
+    /* the kept reports, each one with its stack. */
+    static juce::String getReport();
+    static void reset();
+
+    /* marks the calling thread as real time until it goes out of scope, sections may nest. */
+    class ScopedSection
+    {
+    public:
+#if PULSAR_RT_CHECKS
+        ScopedSection();
+        ~ScopedSection();
+#else
+        ScopedSection() {}
+#endif
+        JUCE_DECLARE_NON_COPYABLE(ScopedSection)
+    };
+};
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    RenderMain.cpp
+
+    Headless batch renderer, see PulsarRender.jucer.
+
+    PulsarRender --spec sweep.json --out renders [--threads 8]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "RealtimeCheck.h"
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    auto printUsage = [&args]
+    {
+        std::cout << "usage: " << args.executableName << " --spec sweep.json --out directory [--threads n]" << std::endl;
+    };
+
+    if (!args.containsOption("--spec") || !args.containsOption("--out"))
+    {
+        printUsage();
+        return 1;
+    }
+
+    /* getExistingFileForOption throws when the file is missing, which only ConsoleApplication would catch. */
+    auto specFile = args.getFileForOption("--spec");
+    auto outputDirectory = args.getFileForOption("--out");
+
+    if (!specFile.existsAsFile())
+    {
+        std::cerr << "no spec file " << specFile.getFullPathName() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    juce::var spec;
+    auto parsed = juce::JSON::parse(specFile.loadFileAsString(), spec);
+
+    if (parsed.failed())
+    {
+        std::cerr << specFile.getFullPathName() << ": " << parsed.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    OfflineRenderer renderer;
+    auto loaded = renderer.loadSweep(spec);
+
+    if (loaded.failed())
+    {
+        std::cerr << loaded.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    /* one render per core unless told otherwise. */
+    auto numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                       : juce::SystemStats::getNumCpus();
+
+    std::cout << "rendering " << renderer.getRenders().size() << " files on " << numThreads << " threads" << std::endl;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    auto rendered = renderer.renderAll(outputDirectory, numThreads);
+
+    if (rendered.failed())
+    {
+        std::cerr << rendered.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    std::cout << "done in " << (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0 << " seconds" << std::endl;
+
+    if (RealtimeCheck::getNumViolations() > 0)
+        std::cerr << RealtimeCheck::getReport() << std::endl;
+
+    return 0;
+}
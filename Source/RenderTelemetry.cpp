@@ -0,0 +1,179 @@
+#include "RenderTelemetry.h"
+
+RenderTelemetry::RenderTelemetry()
+    : timings((size_t)capacity)
+{
+}
+
+RenderTelemetry::~RenderTelemetry()
+{
+}
+
+void RenderTelemetry::addBlock(const BlockTiming& timing)
+{
+    load.store(timing.load, std::memory_order_relaxed);
+
+    /* a compare exchange loop rather than a lock, the reader only ever lowers it back to 0. */
+    auto peak = peakLoad.load(std::memory_order_relaxed);
+
+    while (timing.load > peak && !peakLoad.compare_exchange_weak(peak, timing.load, std::memory_order_relaxed))
+    {
+    }
+
+    if (timing.load > 1.0f)
+        numOverruns.fetch_add(1, std::memory_order_relaxed);
+    else if (timing.load > nearMissLoad)
+        numNearMisses.fetch_add(1, std::memory_order_relaxed);
+
+    if (timing.numLateVoiceWaits > 0)
+        numLateVoiceWaits.fetch_add(timing.numLateVoiceWaits, std::memory_order_relaxed);
+
+    if (!readerAttached.load(std::memory_order_relaxed))
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    timings[(size_t)(size1 > 0 ? start1 : start2)] = timing;
+    fifo.finishedWrite(1);
+}
+
+float RenderTelemetry::getLoad() const
+{
+    return load.load(std::memory_order_relaxed);
+}
+
+float RenderTelemetry::getAndResetPeakLoad()
+{
+    return peakLoad.exchange(0.0f, std::memory_order_relaxed);
+}
+
+int RenderTelemetry::getNumNearMisses() const
+{
+    return numNearMisses.load(std::memory_order_relaxed);
+}
+
+int RenderTelemetry::getNumOverruns() const
+{
+    return numOverruns.load(std::memory_order_relaxed);
+}
+
+int RenderTelemetry::getNumDropped() const
+{
+    return numDropped.load(std::memory_order_relaxed);
+}
+
+int RenderTelemetry::getNumLateVoiceWaits() const
+{
+    return numLateVoiceWaits.load(std::memory_order_relaxed);
+}
+
+int RenderTelemetry::read(BlockTiming* destination, int maxTimings)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(maxTimings, start1, size1, start2, size2);
+
+    std::copy(timings.begin() + start1, timings.begin() + start1 + size1, destination);
+    std::copy(timings.begin() + start2, timings.begin() + start2 + size2, destination + size1);
+
+    fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+void RenderTelemetry::setReaderAttached(bool isAttached)
+{
+    readerAttached.store(isAttached, std::memory_order_relaxed);
+}
+
+juce::int64 RenderTelemetry::getTicks()
+{
+    return juce::Time::getHighResolutionTicks();
+}
+
+double RenderTelemetry::ticksToSeconds(juce::int64 ticks)
+{
+    return juce::Time::highResolutionTicksToSeconds(ticks);
+}
+
+//==============================================================================
+TelemetryWriter::TelemetryWriter(RenderTelemetry& telemetryToRead)
+    : juce::Thread("Pulsar telemetry writer"),
+    telemetry(telemetryToRead),
+    readBuffer((size_t)RenderTelemetry::capacity)
+{
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+    stop();
+}
+
+bool TelemetryWriter::start(const juce::File& file)
+{
+    stop();
+
+    file.deleteFile();
+    stream = file.createOutputStream();
+
+    if (stream == nullptr)
+        return false;
+
+    /* timings from before the file was opened are not wanted. */
+    while (telemetry.read(readBuffer.data(), (int)readBuffer.size()) > 0)
+    {
+    }
+
+    telemetry.setReaderAttached(true);
+
+    *stream << "blockStart,samples,callbackMicroseconds,load,activeVoices,maxVoiceMicroseconds,totalVoiceMicroseconds,lateVoiceWaits\n";
+    startThread();
+    return true;
+}
+
+void TelemetryWriter::stop()
+{
+    telemetry.setReaderAttached(false);
+    stopThread(1000);
+
+    if (stream != nullptr)
+    {
+        writeTimings();
+        stream->flush();
+        stream.reset();
+    }
+}
+
+bool TelemetryWriter::isWriting() const
+{
+    return isThreadRunning();
+}
+
+void TelemetryWriter::run()
+{
+    /* a 4096 block fifo lasts over five seconds at 64 samples and 48kHz, a tenth of a second is plenty. */
+    while (!threadShouldExit())
+    {
+        writeTimings();
+        wait(100);
+    }
+}
+
+void TelemetryWriter::writeTimings()
+{
+    auto numRead = telemetry.read(readBuffer.data(), (int)readBuffer.size());
+
+    for (int i = 0; i < numRead; ++i)
+    {
+        auto& timing = readBuffer[(size_t)i];
+        *stream << timing.blockStart << "," << timing.numSamples << ","
+                << timing.callbackSeconds * 1.0e6 << "," << timing.load << ","
+                << timing.numActiveVoices << "," << timing.maxVoiceSeconds * 1.0e6 << ","
+                << timing.totalVoiceSeconds * 1.0e6 << "," << timing.numLateVoiceWaits << "\n";
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/* how long one audio callback took, against the time it had. */
+struct BlockTiming
+{
+    juce::int64 blockStart = 0;   /* in samples of the output stream. */
+    int numSamples = 0;
+    double callbackSeconds = 0.0;
+
+    /* callbackSeconds over the block's duration, above 1 the block was late. */
+    float load = 0.0f;
+    int numActiveVoices = 0;
+
+    /* the slowest voice and all voices together, whichever thread they were rendered on. */
+    double maxVoiceSeconds = 0.0;
+    double totalVoiceSeconds = 0.0;
+
+    /* times the audio thread waited on a render thread past its deadline, see VoiceRenderPool. */
+    int numLateVoiceWaits = 0;
+};
+
+/*
+* Timings from the audio thread, written without locks or allocation.
+* The latest load, the peak and the miss counters are atomics for a meter to poll.
+* While a reader, a TelemetryWriter, is attached every timing also goes into a fifo for it. When the fifo is full
+* timings are dropped and counted rather than waiting for it.
+*/
+class RenderTelemetry
+{
+public:
+    RenderTelemetry();
+    ~RenderTelemetry();
+
+    static constexpr int capacity = 4096;
+
+    /* above this load a block counts as a near miss, above 1 it overran its deadline. */
+    static constexpr float nearMissLoad = 0.8f;
+
+    /* audio thread. */
+    void addBlock(const BlockTiming& timing);
+
+    /* any thread. the peak is the highest load since the last call. */
+    float getLoad() const;
+    float getAndResetPeakLoad();
+    int getNumNearMisses() const;
+    int getNumOverruns() const;
+    int getNumDropped() const;
+    int getNumLateVoiceWaits() const;
+
+    /* the fifo's one reader, copies out up to maxTimings, returns how many. */
+    int read(BlockTiming* destination, int maxTimings);
+
+    /* the reader, timings only go into the fifo while one is attached. */
+    void setReaderAttached(bool isAttached);
+
+    /* clock for the timings, monotonic. */
+    static juce::int64 getTicks();
+    static double ticksToSeconds(juce::int64 ticks);
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::vector<BlockTiming> timings;
+
+    std::atomic<float> load { 0.0f }, peakLoad { 0.0f };
+    std::atomic<int> numNearMisses { 0 }, numOverruns { 0 }, numDropped { 0 }, numLateVoiceWaits { 0 };
+    std::atomic<bool> readerAttached { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderTelemetry)
+};
+
+/*
+* Drains a RenderTelemetry into a CSV file on its own thread, one line per block.
+* Only one writer may read a RenderTelemetry at a time.
+*/
+class TelemetryWriter : private juce::Thread
+{
+public:
+    TelemetryWriter(RenderTelemetry& telemetryToRead);
+    ~TelemetryWriter() override;
+
+    /* starts writing to file, replacing it. returns false if it could not be opened. */
+    bool start(const juce::File& file);
+    void stop();
+    bool isWriting() const;
+private:
+    void run() override;
+    void writeTimings();
+
+    RenderTelemetry& telemetry;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::vector<BlockTiming> readBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TelemetryWriter)
+};
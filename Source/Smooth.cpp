@@ -10,7 +10,7 @@
 
 #include "Smooth.h"
 
-Smooth::Smooth()
+Smooth::Smooth(Mode modeToUse) : mode(modeToUse)
 {
 }
 
@@ -18,13 +18,92 @@ Smooth::~Smooth()
 {
 }
 
-float Smooth::smooth(float input, int numSamples)
+void Smooth::reset(double sampleRate, double rampLengthInSeconds)
 {
-    float localTarget = input;
-    if (localTarget != current)
+    stepsToTarget = juce::jmax(1, (int)std::floor(rampLengthInSeconds * sampleRate));
+    setCurrentAndTargetValue(target);
+}
+
+void Smooth::changeSampleRate(double sampleRate, double rampLengthInSeconds)
+{
+    auto newStepsToTarget = juce::jmax(1, (int)std::floor(rampLengthInSeconds * sampleRate));
+
+    if (countdown > 0)
+    {
+        countdown = juce::jmax(1, (int)((juce::int64)countdown * newStepsToTarget / juce::jmax(1, stepsToTarget)));
+        updateStep();
+    }
+
+    stepsToTarget = newStepsToTarget;
+}
+
+void Smooth::setTargetValue(float newTarget)
+{
+    if (newTarget == target)
+        return;
+
+    target = newTarget;
+
+    if (stepsToTarget <= 1 || (mode == Mode::exponential && !(current * target > 0.0f)))
     {
-        float increment = (localTarget - current) / numSamples;
-        current += increment;
+        setCurrentAndTargetValue(target);
+        return;
     }
+
+    /* the step is worked out once per change, not once per sample. */
+    countdown = stepsToTarget;
+    updateStep();
+}
+
+void Smooth::updateStep()
+{
+    step = (mode == Mode::linear) ? (target - current) / (float)countdown
+                                  : std::exp((std::log(std::abs(target)) - std::log(std::abs(current))) / (float)countdown);
+}
+
+void Smooth::setCurrentAndTargetValue(float newValue)
+{
+    current = target = newValue;
+    countdown = 0;
+}
+
+float Smooth::getNextValue()
+{
+    if (countdown <= 0)
+        return target;
+
+    if (--countdown == 0)
+        current = target;
+    else
+        current = (mode == Mode::linear) ? current + step : current * step;
+
     return current;
-}
\ No newline at end of file
+}
+
+void Smooth::fillRamp(float* destination, int numSamples)
+{
+    auto numRamped = juce::jmin(countdown, numSamples);
+
+    /* the ramp is a running sum (or product), stepping it keeps it identical to getNextValue. */
+    for (int i = 0; i < numRamped; ++i)
+        destination[i] = getNextValue();
+
+    /* the rest of the block sits on the target. */
+    if (numRamped < numSamples)
+        juce::FloatVectorOperations::fill(destination + numRamped, target, numSamples - numRamped);
+}
+
+bool Smooth::isSmoothing() const
+{
+    return countdown > 0;
+}
+
+float Smooth::getCurrentValue() const
+{
+    return (countdown > 0) ? current : target;
+}
+
+float Smooth::getTargetValue() const
+{
+    return target;
+}
@@ -10,13 +10,47 @@
 
 #pragma once
 
+#include <JuceHeader.h>
+
 //==============================================================================
+/*
+* Ramps a parameter towards its target over a fixed time, whatever the block size.
+* linear ramps add the same step every sample, exponential ramps multiply by the same ratio,
+* which suits frequencies. An exponential ramp that would cross or touch zero jumps instead.
+*
+* fillRamp writes a whole block of the ramp at once, getNextValue steps it one sample,
+* the two give the same values.
+*/
 class Smooth
 {
 public:
-    Smooth();
+    enum class Mode
+    {
+        linear,
+        exponential
+    };
+
+    Smooth(Mode modeToUse = Mode::linear);
     ~Smooth();
-    float smooth(float input, int numSamples);
+
+    void reset(double sampleRate, double rampLengthInSeconds);
+
+    /* like reset but a ramp in progress carries on, over the same time at the new rate. */
+    void changeSampleRate(double sampleRate, double rampLengthInSeconds);
+    void setTargetValue(float newTarget);
+    void setCurrentAndTargetValue(float newValue);
+
+    float getNextValue();
+    void fillRamp(float* destination, int numSamples);
+
+    bool isSmoothing() const;
+    float getCurrentValue() const;
+    float getTargetValue() const;
 private:
-    float current = 0.0f;
-};
\ No newline at end of file
+    void updateStep();
+
+    Mode mode;
+    float current = 0.0f, target = 0.0f;
+    float step = 0.0f;
+    int countdown = 0, stepsToTarget = 0;
+};
@@ -9,339 +9,535 @@
 */
 
 #include "SynthAudioSource.h"
+#include "PulsarVoice.h"
 
 //==============================================================================
-/*
-    PulsarSound is a passive class that describes the sound to a Synthesiser object.
-    The audio rendering is done by the SynthesiserVoice class.
 
-    PulsarSound may choose which midinotes and channels trigger the voice.
+SynthAudioSource::SynthAudioSource(juce::MidiKeyboardState& keyState) : keyboardState(keyState)
+{
+    for (auto i = 0; i < numVoices; ++i)
+        synth.addVoice(new PulsarVoice(audioParameters, i));
 
-    I create the wavetables for both the window and the wavelet here, they are public member variables.
-    I should make the program safer by creating access functions to these variables so they may not be
-    modified but only retreived.
-*/
+    publishParameters();
+    synth.voicesChanged();
+    synth.addSound(new PulsarSound);
 
-struct PulsarSound : public juce::SynthesiserSound
+    /* voices pick their parameters up at the start of each sub block, let midi split them anywhere too. */
+    synth.setMinimumRenderingSubdivisionSize(1);
+    keyboardState.addListener(this);
+}
+
+SynthAudioSource::~SynthAudioSource()
+{
+    keyboardState.removeListener(this);
+}
+
+void SynthAudioSource::setNumVoices(int newNumVoices)
 {
-    PulsarSound()
+    newNumVoices = juce::jmax(1, newNumVoices);
+
+    /*
+    * a voice allocates its pulsar, decimators and grains when it is made and prepared, so that happens
+    * before addVoice, which only takes the synth's lock to put it in the list.
+    */
+    while (synth.getNumVoices() < newNumVoices)
     {
-    };
+        auto* voice = new PulsarVoice(audioParameters, synth.getNumVoices());
+        voice->setCurrentPlaybackSampleRate(synth.getSampleRate());
+        synth.addVoice(voice);
+    }
 
-    bool appliesToNote(int) override { return true; }
-    bool appliesToChannel(int) override { return true; }
+    while (synth.getNumVoices() > newNumVoices)
+        synth.removeVoice(synth.getNumVoices() - 1);
 
-    juce::AudioSampleBuffer sineTable;
-    juce::AudioSampleBuffer windowTable;
+    /* the render pool is rebuilt outside the lock, so the audio thread is not held up while threads start. */
+    numVoices = newNumVoices;
+    synth.voicesChanged();
+    updateRenderThreads();
+}
 
-private:
-    const unsigned int tableSize = 1 << 9;
-};
+int SynthAudioSource::getNumVoices() const
+{
+    return numVoices;
+}
 
-//==============================================================================
-// A voice plays a single sound at a time but a Synthesiser can hold an array of voices.
-struct PulsarVoice : public juce::SynthesiserVoice
+void SynthAudioSource::setNumRenderThreads(int numThreads)
+{
+    numRenderThreads = numThreads;
+    updateRenderThreads();
+}
+
+/* a single voice always renders on the audio thread, so it gets no workers to keep awake. */
+void SynthAudioSource::updateRenderThreads()
+{
+    auto numThreads = 0;
+
+    if (numVoices > 1)
+        numThreads = numRenderThreads < 0 ? juce::SystemStats::getNumCpus() - 1 : numRenderThreads;
+
+    if (numThreads != synth.getNumRenderThreads())
+        synth.setNumRenderThreads(numThreads);
+}
+
+void SynthAudioSource::setNumOutputChannels(int numChannels)
 {
-    /* set adsr sample rate in SineWaveVoice constructor. */
-    PulsarVoice()
+    numOutputChannels = juce::jmax(1, numChannels);
+}
+
+void SynthAudioSource::setUsingPulsarSound()
+{
+    synth.clearSounds();
+}
+
+void SynthAudioSource::setRealtime(bool isRealtime)
+{
+    realtime = isRealtime;
+}
+
+// I don't need to include the override keyword in the declaration
+void SynthAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    synth.setCurrentPlaybackSampleRate(sampleRate);
+    synth.prepareToRender(numOutputChannels, samplesPerBlockExpected);
+
+    currentSampleRate = sampleRate;
+    expectedBlockSize = samplesPerBlockExpected;
+    blockMidi.ensureSize(2048);
+}
+
+void SynthAudioSource::releaseResources()
+{
+}
+
+// AudioSourceChannelInfo is a struct used by getNextAudioBlock. 
+void SynthAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffertToFill)
+{
+    buffertToFill.clearActiveBufferRegion();
+    renderBlock(*buffertToFill.buffer, noMidi, buffertToFill.startSample, buffertToFill.numSamples);
+}
+
+void SynthAudioSource::renderNextBlock(juce::AudioSampleBuffer& buffer, const juce::MidiBuffer& midi, int startSample, int numSamples)
+{
+    renderBlock(buffer, midi, startSample, numSamples);
+}
+
+void SynthAudioSource::applyParameters(const PulsarParameters& parameters)
+{
+    setAudioParameters(parameters);
+}
+
+void SynthAudioSource::setAudioParameters(const PulsarParameters& parameters)
+{
+    audioParameters = parameters;
+    applyTables();
+}
+
+void SynthAudioSource::applyTables()
+{
+    audioParameters.carrierTable = tables != nullptr ? tables->carrier : nullptr;
+    audioParameters.windowTable  = tables != nullptr ? tables->window  : nullptr;
+    audioParameters.tableGeneration = tables != nullptr ? tables->generation : 0;
+}
+
+void SynthAudioSource::allNotesOff()
+{
+    synth.allNotesOff(0, false);
+}
+
+void SynthAudioSource::renderBlock(juce::AudioSampleBuffer& buffer, const juce::MidiBuffer& hostMidi, int startSample, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    const RealtimeCheck::ScopedSection realtime;
+    auto startTicks = RenderTelemetry::getTicks();
+    auto blockStart = renderedSamples.load(std::memory_order_relaxed);
+    streamStartTime.store(juce::Time::getMillisecondCounterHiRes() * 0.001 - (double)blockStart / currentSampleRate,
+                          std::memory_order_relaxed);
+
+    /* the tables for the whole block, the builder keeps them until the next block acquires. */
+    tables = tableBuilder.acquire();
+    applyTables();
+
+    /* a change was dropped, the queued ones before it are older, so the store is applied once they are through. */
+    if (auto dropped = droppedSequence.exchange(0))
+        catchUpSequence = dropped;
+
+    /*
+    * events due in this block are applied in order. midi is collected and the synth places it itself,
+    * a parameter change renders everything up to its sample first, then swaps the snapshot every voice reads.
+    * The host's midi is already placed, it is merged in range by range.
+    */
+    blockMidi.clear();
+    auto position = 0;
+    auto hostEvent = hostMidi.findNextSamplePosition(startSample);
+
+    auto renderUpTo = [&](int offset)
     {
-        adsr.setSampleRate(getSampleRate());
-        createSineTable();
-        createWindowTable();
-        /* I use a unique pointer to handle the deletion of memory for me. */
-        _pulsar = std::make_unique<Pulsar>(sineTable, windowTable);
+        for (; hostEvent != hostMidi.cend() && (*hostEvent).samplePosition < startSample + offset; ++hostEvent)
+            blockMidi.addEvent((*hostEvent).data, (*hostEvent).numBytes, (*hostEvent).samplePosition);
+
+        renderRange(buffer, startSample + position, offset - position);
+        position = offset;
     };
 
-    /* In this case there is only one sound, so returns true if not a nullptr. */
-    bool canPlaySound(juce::SynthesiserSound* sound) override
+    while (auto* event = eventQueue.peek())
     {
-        /* 
-        * dynamic cast accesses the custom SynthesiserSound struct, rather than the base class.
-        * so check if sound is not a null pointer and then return true so this voice can play a sound.
-        */
-        return dynamic_cast <PulsarSound*> (sound) != nullptr;
-    }
+        if (event->samplePosition >= blockStart + numSamples)
+            break;
 
-    void startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound*, int /*currentPitchWheelPosition*/)
-    {
-        /* edit this to spread notes over octave (seee the wavetable tutorial) */
-        auto cyclesPerSecond = juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber);
-        cyclesPerSample = (float)cyclesPerSecond / (float)getSampleRate();
-
-        /*
-        * calculate 12th root equal tempered scale.
-        * there is a midi note to Hz juce function but I want to modify the conversion to include other scales.
-        */
-        frequency = 440.0 * pow(2.0, (midiNoteNumber - 69.0) / 12.0);
-
-        level = velocity * 0.5f;
-        adsr.noteOn();
-        
-        if (_keyboardControl)
+        auto offset = (int)juce::jlimit((juce::int64)position, (juce::int64)numSamples - 1, event->samplePosition - blockStart);
+
+        if (event->type == SynthEvent::Type::midi)
         {
-            _pulsar->setFundamental((float)frequency);
-        } else 
+            blockMidi.addEvent(event->midiData, event->midiSize, startSample + offset);
+        }
+        else
         {
-            _pulsar->setFundamental(_fundamental);
+            renderUpTo(offset);
+            setAudioParameters(event->parameters);
+
+            /* published after the dropped change, so it already holds it. */
+            if (event->sequence >= catchUpSequence)
+                catchUpSequence = 0;
         }
-        
-        _pulsar->setPeriod(_period, _periodSpread);
-        _pulsar->setFormant(_formant);
-        _pulsar->setIndex(_index);
-        _pulsar->setStochasticMasking(_masking);
+
+        eventQueue.pop();
     }
 
-    void stopNote(float /*velocity*/, bool)
+    catchUpDroppedEvents(startSample + position);
+    renderUpTo(numSamples);
+    renderedSamples.store(blockStart + numSamples, std::memory_order_relaxed);
+    addTiming(blockStart, numSamples, startTicks);
+}
+
+/*
+* after the block's last queued change, so an older snapshot still in the queue cannot overwrite the latest.
+* An older change due in a later block would, so the store is applied again until the queue has drained.
+* A dropped note off waits for the queue to drain too, the note on it stops may still be queued.
+*/
+void SynthAudioSource::catchUpDroppedEvents(int samplePosition)
+{
+    auto drained = (eventQueue.peek() == nullptr);
+
+    if (catchUpSequence != 0)
     {
-        adsr.noteOff();
+        parameterStore.update();
+        setAudioParameters(parameterStore.get());
+
+        if (drained)
+            catchUpSequence = 0;
     }
 
-    // pure virtual functions must be initialised.
-    void pitchWheelMoved(int)      override {};
-    void controllerMoved(int, int) override {};
+    if (!drained || !noteOffsDropped.exchange(false))
+        return;
 
-    // renderNextBlock now uses an adsr.
-    void renderNextBlock(juce::AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override
+    for (auto word = 0; word < (int)droppedNoteOffs.size(); ++word)
     {
+        auto notes = droppedNoteOffs[(size_t)word].exchange(0);
 
-        /* amplitde envelope params */
-        amplitudeParameters.attack  = amplitudeAttack;
-        amplitudeParameters.decay   = amplitudeDecay;
-        amplitudeParameters.sustain = amplitudeSustain;
-        amplitudeParameters.release = amplitudeRelease;
-        
-        adsr.setParameters(amplitudeParameters);
-
-        while (--numSamples >= 0)
+        for (auto bit = 0; notes != 0; ++bit, notes >>= 1)
         {
+            if ((notes & 1) == 0)
+                continue;
 
-             if (_keyboardControl)
-             {
-                 _pulsar->setFundamental((float)frequency);
-             }
-             else
-             {
-                 auto smoothFundamental = fundamentalSmooth.smooth(_fundamental, numSamples);
-                 _pulsar->setFundamental(smoothFundamental);
-             }
-
-             auto smoothPeriod = periodSmooth.smooth(_period, numSamples);
-             auto smoothSpread = periodSpreadSmooth.smooth(_periodSpread, numSamples);
-             auto smoothFormant = formantSmooth.smooth(_formant, numSamples);
-             auto smoothIndex = indexSmooth.smooth(_index, numSamples);
-             
-             _pulsar->setPeriod(smoothPeriod, smoothSpread);
-             _pulsar->setFormant(smoothFormant);
-             _pulsar->setIndex(smoothIndex);
-             _pulsar->setStochasticMasking(_masking);
-
-             float currentSample = _pulsar->getNextSample((float)getSampleRate()) * level * adsr.getNextSample();
-
-             for (auto i = outputBuffer.getNumChannels(); --i >= 0;)
-             {
-                 outputBuffer.addSample(i, startSample, currentSample);
-             }
-             
-             ++startSample;
-
-             if (!adsr.isActive())
-             {
-                 /* reset pulsar? */
-                 clearCurrentNote();
-                 break;
-             }
+            auto index = word * 32 + bit;
+            auto noteOff = juce::MidiMessage::noteOff(index / 128 + 1, index % 128);
+            blockMidi.addEvent(noteOff, samplePosition);
         }
     }
+}
 
-    void createWindowTable()
-    {
-        windowTable.setSize(1, (int)tableSize + 1);
-        windowTable.clear();
+void SynthAudioSource::addTiming(juce::int64 blockStart, int numSamples, juce::int64 startTicks)
+{
+    auto voiceTimes = synth.getAndResetVoiceTimes();
+
+    BlockTiming timing;
+    timing.blockStart = blockStart;
+    timing.numSamples = numSamples;
+    timing.numActiveVoices = voiceTimes.numActiveVoices;
+    timing.maxVoiceSeconds = voiceTimes.maxVoiceSeconds;
+    timing.totalVoiceSeconds = voiceTimes.totalVoiceSeconds;
+    timing.numLateVoiceWaits = voiceTimes.numLateWaits;
+
+    timing.callbackSeconds = RenderTelemetry::ticksToSeconds(RenderTelemetry::getTicks() - startTicks);
+    timing.load = (float)(timing.callbackSeconds * currentSampleRate / (double)numSamples);
+    telemetry.addBlock(timing);
+}
 
-        auto* samples = windowTable.getWritePointer(0);
+RenderTelemetry& SynthAudioSource::getTelemetry()
+{
+    return telemetry;
+}
 
-        auto angleDelta = juce::MathConstants<double>::twoPi / (double)(tableSize - 1);
-        auto currentAngle = 0.0;
+/*
+* the synth handles any midi past the end of the range once it has rendered, so the buffer only ever
+* holds midi up to the end of this range and is emptied once it has been used.
+*/
+void SynthAudioSource::renderRange(juce::AudioSampleBuffer& buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
 
-        for (unsigned int i = 0; i < tableSize; ++i)
-        {
-            auto sample = 0.5 - 0.5 * cos(currentAngle);
-            samples[i] = (float)sample;
-            currentAngle += angleDelta;
-        }
+    synth.renderNextBlock(buffer, blockMidi, startSample, numSamples);
+    blockMidi.clear();
+}
 
-        samples[tableSize] = samples[0];
-    }
+juce::int64 SynthAudioSource::getEventPosition()
+{
+    auto position = renderedSamples.load(std::memory_order_relaxed);
 
-    void createSineTable()
+    if (realtime)
     {
-        /*
-        * set table size with 1 channel.
-        * get write pointer channel 0.
-        */
+        /* one block later than now, so it lands inside the next block rather than on its first sample. */
+        auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        position = juce::jmax(position, (juce::int64)((now - streamStartTime.load(std::memory_order_relaxed)) * currentSampleRate)
+                                            + expectedBlockSize);
+    }
 
-        sineTable.setSize(1, (int)tableSize + 1);
-        sineTable.clear();
+    /* another thread may raise it in between, so only ever move it forward. */
+    auto last = lastEventPosition.load(std::memory_order_relaxed);
 
-        auto* samples = sineTable.getWritePointer(0);
+    while (last < position && !lastEventPosition.compare_exchange_weak(last, position, std::memory_order_relaxed))
+    {
+    }
 
-        auto angleDelta = juce::MathConstants<double>::twoPi / (double)(tableSize - 1);
-        auto currentAngle = 0.0;
+    return juce::jmax(last, position);
+}
 
-        for (unsigned int i = 0; i < tableSize; ++i)
-        {
-            auto sample = std::sin(currentAngle);
-            samples[i] = (float)sample;
-            currentAngle += angleDelta;
-        }
+void SynthAudioSource::publishParameters()
+{
+    parameterStore.publish(editParameters);
 
-        samples[tableSize] = samples[0];
-    }
-    float amplitudeAttack = 0.0f, amplitudeDecay = 0.0f, amplitudeSustain = 0.0f, amplitudeRelease = 0.0f;
-    float _fundamental = 100.0f;
-    bool _keyboardControl = false;
-    float _period = 0.0f, _periodSpread = 0.0f;
-    float _formant = 0.0f;
-    float _index = 0.0f;
-    int   _masking = 0;
-private:
-    juce::ADSR::Parameters amplitudeParameters { 0.1f, 0.1f, 0.5f, 0.1f };
-    juce::ADSR adsr;
-    std::unique_ptr<Pulsar> _pulsar;
-    float level = 0.0f;
-    float cyclesPerSample = 0.0f;
-    juce::AudioSampleBuffer sineTable;
-    juce::AudioSampleBuffer windowTable;
-    const unsigned int tableSize = 1 << 9;
-    juce::Random random;
-    Smooth fundamentalSmooth, periodSmooth, periodSpreadSmooth, formantSmooth, indexSmooth;
-    double frequency = 0.0;
-};
+    SynthEvent event;
+    event.type = SynthEvent::Type::parameters;
+    event.samplePosition = getEventPosition();
+    event.parameters = editParameters;
+    event.sequence = ++parameterSequence;
 
-//==============================================================================
+    if (!eventQueue.push(event))
+        droppedSequence = event.sequence;
+}
 
-SynthAudioSource::SynthAudioSource(juce::MidiKeyboardState& keyState) : keyboardState(keyState)
+void SynthAudioSource::pushMidi(const juce::MidiMessage& message)
 {
-    for (auto i = 0; i < numVoices; ++i)
+    SynthEvent event;
+    event.type = SynthEvent::Type::midi;
+    event.samplePosition = getEventPosition();
+    event.midiSize = juce::jmin(message.getRawDataSize(), 3);
+    std::copy(message.getRawData(), message.getRawData() + event.midiSize, event.midiData);
+
+    auto note = (message.getChannel() - 1) * 128 + message.getNoteNumber();
+    auto noteBit = (juce::uint32)1 << (note % 32);
+    auto& noteWord = droppedNoteOffs[(size_t)(note / 32)];
+
+    if (eventQueue.push(event))
     {
-        synth.addVoice(new PulsarVoice);
+        /* the synth stops a note that is played again, so it no longer needs stopping. */
+        if (message.isNoteOn())
+            noteWord &= ~noteBit;
+
+        return;
     }
 
-    synth.addSound(new PulsarSound);
+    /* a lost note on is a missed note, a lost note off would leave it hanging, so it is stopped later. */
+    if (message.isNoteOff())
+    {
+        noteWord |= noteBit;
+        noteOffsDropped = true;
+    }
 }
 
-void SynthAudioSource::setUsingPulsarSound()
+/* keyboard listener, called on whichever thread pressed the key. */
+void SynthAudioSource::handleNoteOn(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
 {
-    synth.clearSounds();
+    pushMidi(juce::MidiMessage::noteOn(midiChannel, midiNoteNumber, velocity));
 }
 
-// I don't need to include the override keyword in the declaration
-void SynthAudioSource::prepareToPlay(int, double sampleRate)
+void SynthAudioSource::handleNoteOff(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
 {
-    synth.setCurrentPlaybackSampleRate(sampleRate);
+    pushMidi(juce::MidiMessage::noteOff(midiChannel, midiNoteNumber, velocity));
 }
 
-void SynthAudioSource::releaseResources()
+/*
+* the setters run on the message thread. each one edits the gui side copy and queues all of it,
+* stamped with the sample it should take effect on.
+*/
+void SynthAudioSource::amplitudeEnvelope(float set_attack, float set_decay, float set_sustain, float set_release)
 {
+    editParameters.attack  = set_attack;
+    editParameters.decay   = set_decay;
+    editParameters.sustain = set_sustain;
+    editParameters.release = set_release;
+    publishParameters();
 }
 
-// AudioSourceChannelInfo is a struct used by getNextAudioBlock. 
-void SynthAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffertToFill)
+void SynthAudioSource::setFundamental(float fundamental)
 {
-    buffertToFill.clearActiveBufferRegion();
+    editParameters.fundamental = fundamental;
+    publishParameters();
+}
 
-    juce::MidiBuffer incomingMidi;
-    keyboardState.processNextMidiBuffer (incomingMidi, buffertToFill.startSample, buffertToFill.numSamples, true);
-    synth.renderNextBlock (*buffertToFill.buffer, incomingMidi, buffertToFill.startSample, buffertToFill.numSamples);
+void SynthAudioSource::setKeyboardControl(bool keyboardControl)
+{
+    editParameters.keyboardControl = keyboardControl;
+    publishParameters();
 }
 
-void SynthAudioSource::amplitudeEnvelope(float set_attack, float set_decay, float set_sustain, float set_release)
-{ 
-   for (auto i = 0; i < synth.getNumVoices(); ++i)
-   {
-       juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-       PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };                 
-       
-       PulsarVoicePtr->amplitudeAttack  = set_attack;
-       PulsarVoicePtr->amplitudeDecay   = set_decay;
-       PulsarVoicePtr->amplitudeSustain = set_sustain;
-       PulsarVoicePtr->amplitudeRelease = set_release;
-   }
+void SynthAudioSource::setPeriod(float period)
+{
+    editParameters.period = period;
+    publishParameters();
 }
 
-void SynthAudioSource::setFundamental(float fundamental)
+void SynthAudioSource::setPeriodSpread(float spread)
 {
-    for (auto i = 0; i < synth.getNumVoices(); ++i)
-    {
-        juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-        PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };
-       
-        PulsarVoicePtr->_fundamental = fundamental;
-    }
+    editParameters.periodSpread = spread;
+    publishParameters();
 }
 
-void SynthAudioSource::setKeyboardControl(bool keyboardControl)
+void SynthAudioSource::setFormant(float formant)
 {
-    for (auto i = 0; i < synth.getNumVoices(); ++i)
-    {
-        juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-        PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };
+    editParameters.formant = formant;
+    publishParameters();
+}
 
-        PulsarVoicePtr->_keyboardControl = keyboardControl;
-    }
+void SynthAudioSource::setIndex(float index)
+{
+    editParameters.index = index;
+    publishParameters();
 }
 
-void SynthAudioSource::setPeriod(float period)
+void SynthAudioSource::setMasking(int masking)
 {
-    for (auto i = 0; i < synth.getNumVoices(); ++i)
-    {
-        juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-        PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };
+    editParameters.masking = masking;
+    publishParameters();
+}
 
-        PulsarVoicePtr->_period = period;
-    }
+void SynthAudioSource::setMaskingPattern(juce::uint32 pattern, int length)
+{
+    editParameters.maskingPattern = pattern;
+    editParameters.maskingPatternLength = length;
+    publishParameters();
 }
 
-void SynthAudioSource::setPeriodSpread(float spread)
+void SynthAudioSource::setMaskingSeed(int seed)
 {
-    for (auto i = 0; i < synth.getNumVoices(); ++i)
-    {
-        juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-        PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };
+    editParameters.maskingSeed = seed;
+    publishParameters();
+}
 
-        PulsarVoicePtr->_periodSpread = spread;
-    }
+void SynthAudioSource::setFixedPointPhase(bool useFixedPoint)
+{
+    editParameters.fixedPointPhase = useFixedPoint;
+    publishParameters();
 }
 
-void SynthAudioSource::setFormant(float formant)
+void SynthAudioSource::setNumPulsarets(int numPulsarets)
 {
-    for (auto i = 0; i < synth.getNumVoices(); ++i)
-    {
-        juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-        PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };
+    editParameters.numPulsarets = numPulsarets;
+    publishParameters();
+}
 
-        PulsarVoicePtr->_formant  = formant;
-    }
+void SynthAudioSource::setInterpolation(Wavetable::Interpolation waveletInterpolation, Wavetable::Interpolation windowInterpolation)
+{
+    editParameters.waveletInterpolation = waveletInterpolation;
+    editParameters.windowInterpolation = windowInterpolation;
+    publishParameters();
 }
 
-void SynthAudioSource::setIndex(float index)
+void SynthAudioSource::setWindowShape(WindowTables::Shape windowShape)
 {
-    for (auto i = 0; i < synth.getNumVoices(); ++i)
-    {
-        juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-        PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };
+    editParameters.windowShape = windowShape;
+    publishParameters();
+}
 
-        PulsarVoicePtr->_index = index;
-    }
+void SynthAudioSource::setModulation(Pulsar::Routing routing, bool phaseModulation)
+{
+    editParameters.routing = routing;
+    editParameters.phaseModulation = phaseModulation;
+    publishParameters();
 }
 
-void SynthAudioSource::setMasking(int masking)
+void SynthAudioSource::setModulatorRatios(float ratioOne, float ratioTwo)
 {
-    for (auto i = 0; i < synth.getNumVoices(); ++i)
-    {
-        juce::SynthesiserVoice* voicePtr{ synth.getVoice(i) };
-        PulsarVoice* PulsarVoicePtr{ dynamic_cast<PulsarVoice*> (voicePtr) };
+    editParameters.ratioOne = ratioOne;
+    editParameters.ratioTwo = ratioTwo;
+    publishParameters();
+}
 
-        PulsarVoicePtr->_masking = masking;
-    }
+void SynthAudioSource::setFeedback(float feedback)
+{
+    editParameters.feedback = feedback;
+    publishParameters();
+}
+
+void SynthAudioSource::setOversampling(int maxFactor, float threshold)
+{
+    editParameters.oversampling = maxFactor;
+    editParameters.oversamplingThreshold = threshold;
+    publishParameters();
+}
+
+void SynthAudioSource::setPanning(bool panning, float pan, float spread)
+{
+    editParameters.panning = panning;
+    editParameters.pan = pan;
+    editParameters.panSpread = spread;
+    publishParameters();
+}
+
+void SynthAudioSource::setCloud(float density, float spread, float width)
+{
+    editParameters.cloudDensity = density;
+    editParameters.cloudSpread = spread;
+    editParameters.cloudWidth = width;
+    publishParameters();
+}
+
+juce::Result SynthAudioSource::loadWavetableBank(const juce::File& file, int frameSize)
+{
+    auto newBank = std::make_shared<MappedWavetableBank>();
+    auto result = newBank->open(file, frameSize);
+
+    if (result.failed())
+        return result;
+
+    /* the old bank is unmapped once no published set uses it any more. */
+    tableRecipe.bank = std::move(newBank);
+    tableBuilder.request(tableRecipe);
+    return result;
+}
+
+void SynthAudioSource::setWavetableFrames(int carrierFrame, int windowFrame)
+{
+    tableRecipe.carrierFrame = carrierFrame;
+    tableRecipe.windowFrame = windowFrame;
+    tableBuilder.request(tableRecipe);
+}
+
+int SynthAudioSource::getNumWavetableFrames() const
+{
+    return tableRecipe.bank == nullptr ? 0 : tableRecipe.bank->getNumFrames();
+}
+
+void SynthAudioSource::setCarrierHarmonics(const std::vector<float>& harmonics)
+{
+    tableRecipe.harmonics = harmonics;
+    tableBuilder.request(tableRecipe);
+}
+
+bool SynthAudioSource::waitForTables(int timeoutMilliseconds)
+{
+    return tableBuilder.waitUntilBuilt(timeoutMilliseconds);
+}
+
+int SynthAudioSource::getLatencySamples() const
+{
+    return getLatencySamples(editParameters);
+}
+
+int SynthAudioSource::getLatencySamples(const PulsarParameters& parameters)
+{
+    return (parameters.oversampling > 1 && parameters.cloudDensity <= 0.0f) ? OversamplingDecimator::latencySamples : 0;
 }
\ No newline at end of file
@@ -11,17 +11,48 @@
 #include <JuceHeader.h>
 #include "Smooth.h"
 #include "Pulsar.h"
+#include "HalfbandDecimator.h"
+#include "WavetableBank.h"
+#include "TableBuilder.h"
+#include "PulsarSynthesiser.h"
+#include "PulsarParameters.h"
+#include "SynthEventQueue.h"
+#include "RealtimeCheck.h"
+#include "RenderTelemetry.h"
 
 #pragma once
 
-class SynthAudioSource : public juce::AudioSource
+/*
+* The keyboard and the parameter setters do not reach the synth directly, each change is queued
+* with the sample it should land on, and getNextAudioBlock splits its block at those samples.
+* Live, a change made between two callbacks lands at the same point of the next block, a block late
+* but exactly as far apart as the changes were made. Offline it lands at the start of the next block.
+*/
+class SynthAudioSource : public juce::AudioSource,
+    private juce::MidiKeyboardState::Listener
 {
 public:
     SynthAudioSource(juce::MidiKeyboardState& keyState);
+    ~SynthAudioSource() override;
     void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
     void releaseResources() override;
     void setUsingPulsarSound();
     void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    /*
+    * for hosts that send their own midi, placed in buffer samples. Adds to the buffer rather than replacing it.
+    * Queued events are still applied, so the keyboard and the setters keep working.
+    */
+    void renderNextBlock(juce::AudioSampleBuffer& buffer, const juce::MidiBuffer& midi, int startSample, int numSamples);
+
+    /*
+    * audio thread, for hosts that automate from the audio thread. Replaces the snapshot the voices read
+    * from the next block on, without going through the queue. A later queued change still overrides it.
+    */
+    void applyParameters(const PulsarParameters& parameters);
+
+    /* audio thread, cuts every voice off without its release. */
+    void allNotesOff();
     void amplitudeEnvelope(float set_attack, float set_decay, float set_sustain, float set_release);
     void setFundamental(float fundamental);
     void setKeyboardControl(bool keyboardControl);
@@ -29,10 +60,145 @@ public:
     void setPeriodSpread(float spread);
     void setFormant(float formant);
     void setIndex(float index);
+
+    /* operator routing and ratios, see Pulsar::Routing. */
+    void setModulation(Pulsar::Routing routing, bool phaseModulation);
+    void setModulatorRatios(float ratioOne, float ratioTwo);
+    void setFeedback(float feedback);
+
+    /* waveforms per pulse, 1 to Pulsar::maxWavelets. */
+    void setNumPulsarets(int numPulsarets);
+
+    /* table interpolation, for the wavelets and for the window separately. */
+    void setInterpolation(Wavetable::Interpolation waveletInterpolation, Wavetable::Interpolation windowInterpolation);
+
+    /* pulsaret envelope, see WindowTables. */
+    void setWindowShape(WindowTables::Shape windowShape);
     void setMasking(int masking);
+
+    /* on/off masking pattern instead of random masking, a length of 0 goes back to random. */
+    void setMaskingPattern(juce::uint32 pattern, int length);
+
+    /* each voice seeds its masking from this and its voice number, so a seeded render repeats exactly. */
+    void setMaskingSeed(int seed);
+
+    /* integer phase accumulators, for long running pieces, see Pulsar::PhaseMode. */
+    void setFixedPointPhase(bool useFixedPoint);
+
+    /* see PulsarParameters::oversampling. */
+    void setOversampling(int maxFactor, float threshold);
+
+    /* see PulsarParameters::panning, for multichannel outputs as well as stereo. */
+    void setPanning(bool panning, float pan, float spread);
+
+    /* see PulsarParameters::cloudDensity, a density of 0 goes back to the pulse train. */
+    void setCloud(float density, float spread, float width);
+
+    /*
+    * message thread, as are the table setters below. Maps a wavetable file, see MappedWavetableBank, and moves
+    * the frames chosen with setWavetableFrames over to it. The tables are built by a TableBuilder in the background,
+    * the voices keep the tables they have until the new ones are ready, a note never waits for them.
+    */
+    juce::Result loadWavetableBank(const juce::File& file, int frameSize = 0);
+
+    /* frames of the loaded bank for the carriers and the window, -1 for the carrier harmonics and windowShape. */
+    void setWavetableFrames(int carrierFrame, int windowFrame);
+    int getNumWavetableFrames() const;
+
+    /* the carriers' harmonics, harmonics[h - 1] for harmonic h, empty for a sine. A carrier frame takes precedence. */
+    void setCarrierHarmonics(const std::vector<float>& harmonics);
+
+    /* for offline renders, so the first note already has its tables. false if they took longer than the timeout. */
+    bool waitForTables(int timeoutMilliseconds = 10000);
+
+    /* the delay the voices add, for the host to compensate. */
+    int getLatencySamples() const;
+    static int getLatencySamples(const PulsarParameters& parameters);
+
+    /* the output's channel count, for the render threads' scratch buffers. Call before prepareToPlay. */
+    void setNumOutputChannels(int numChannels);
+
+    /* polyphony, call from the message thread. */
+    void setNumVoices(int newNumVoices);
+    int getNumVoices() const;
+
+    /*
+    * extra threads the voices are rendered on. The default, -1, is one less than the number of cores.
+    * None are started while there is only one voice.
+    */
+    void setNumRenderThreads(int numThreads);
+
+    /* false when rendering faster than real time, changes then land at the start of the next block. */
+    void setRealtime(bool isRealtime);
+
+    /* how long each block took to render, against its deadline. */
+    RenderTelemetry& getTelemetry();
 private:
+    void handleNoteOn(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+    void handleNoteOff(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+
+    /*
+    * the sample of the output stream a change made now should land on, never before the last change.
+    * safe to call from any thread.
+    */
+    juce::int64 getEventPosition();
+    void publishParameters();
+
+    /* audio thread, every new snapshot goes through here so the tables stay the ones acquired for this block. */
+    void setAudioParameters(const PulsarParameters& parameters);
+    void applyTables();
+    void pushMidi(const juce::MidiMessage& message);
+    void updateRenderThreads();
+    void catchUpDroppedEvents(int samplePosition);
+    void addTiming(juce::int64 blockStart, int numSamples, juce::int64 startTicks);
+
+    void renderBlock(juce::AudioSampleBuffer& buffer, const juce::MidiBuffer& hostMidi, int startSample, int numSamples);
+
+    /* renders [startSample, startSample + numSamples) of the block with the midi queued up to there. */
+    void renderRange(juce::AudioSampleBuffer& buffer, int startSample, int numSamples);
+
     // base class for a synthesiser.
-    juce::Synthesiser synth;
+    PulsarSynthesiser synth;
+
+    RenderTelemetry telemetry;
     juce::MidiKeyboardState& keyboardState;
     int numVoices = 1;
+    int numRenderThreads = -1;
+    int numOutputChannels = 2;
+
+    /* the message thread's recipe, and the tables the audio thread acquired for the current block. */
+    TableBuilder tableBuilder;
+    TableRecipe tableRecipe;
+    const TableSet* tables = nullptr;
+
+    /* editParameters belongs to the message thread, audioParameters to the audio thread. */
+    PulsarParameters editParameters, audioParameters;
+
+    /*
+    * the events, and the latest snapshot for when the queue was full and a change was dropped.
+    * droppedSequence is the last change dropped, catchUpSequence the audio thread's copy until it has caught up.
+    */
+    SynthEventQueue eventQueue;
+    PulsarParameterStore parameterStore;
+    int parameterSequence = 0, catchUpSequence = 0;
+    std::atomic<int> droppedSequence { 0 };
+
+    /* one bit per channel and note whose note off was dropped, set by the keyboard's thread. */
+    std::array<std::atomic<juce::uint32>, 16 * 128 / 32> droppedNoteOffs {};
+    std::atomic<bool> noteOffsDropped { false };
+
+    /*
+    * the audio thread's place in the output stream. streamStartTime is when (in seconds on the
+    * hi res clock) sample 0 would have been rendered if every block had been on time.
+    */
+    std::atomic<juce::int64> renderedSamples { 0 };
+    std::atomic<double> streamStartTime { 0.0 };
+    double currentSampleRate = 44100.0;
+    int expectedBlockSize = 512;
+    bool realtime = true;
+
+    /* raised by every producer, the setters on the message thread and the keyboard on a midi input thread. */
+    std::atomic<juce::int64> lastEventPosition { 0 };
+
+    juce::MidiBuffer blockMidi, noMidi;
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "SynthEventQueue.h"
+
+SynthEventQueue::SynthEventQueue()
+    : events((size_t)capacity)
+{
+}
+
+SynthEventQueue::~SynthEventQueue()
+{
+}
+
+bool SynthEventQueue::push(const SynthEvent& event)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+        return false;
+
+    events[(size_t)(size1 > 0 ? start1 : start2)] = event;
+    fifo.finishedWrite(1);
+    return true;
+}
+
+const SynthEvent* SynthEventQueue::peek() const
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+        return nullptr;
+
+    return &events[(size_t)(size1 > 0 ? start1 : start2)];
+}
+
+void SynthEventQueue::pop()
+{
+    fifo.finishedRead(1);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PulsarParameters.h"
+
+/*
+* A parameter change or a short MIDI message, stamped with the sample of the output stream it belongs on.
+* Parameter changes carry the whole snapshot, the same as PulsarParameterStore.
+*/
+struct SynthEvent
+{
+    enum class Type
+    {
+        parameters,
+        midi
+    };
+
+    Type type = Type::parameters;
+    juce::int64 samplePosition = 0;
+    PulsarParameters parameters;
+
+    /* parameter changes are numbered as they are published, so a snapshot can be told from an older one. */
+    int sequence = 0;
+    juce::uint8 midiData[3] {};
+    int midiSize = 0;
+};
+
+/*
+* Hands timestamped events from one writer thread to the audio thread, a lock free fifo of preallocated slots.
+* Events are read in the order they were written, the writer keeps their positions in order.
+*/
+class SynthEventQueue
+{
+public:
+    SynthEventQueue();
+    ~SynthEventQueue();
+
+    /* AbstractFifo keeps one slot free, so at most capacity - 1 events are waiting at once. */
+    static constexpr int capacity = 256;
+
+    /* writer thread. returns false, dropping the event, if the queue is full. */
+    bool push(const SynthEvent& event);
+
+    /* reader thread. the oldest event without removing it, nullptr when the queue is empty. */
+    const SynthEvent* peek() const;
+    void pop();
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::vector<SynthEvent> events;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthEventQueue)
+};
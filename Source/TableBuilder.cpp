@@ -0,0 +1,134 @@
+#include "TableBuilder.h"
+
+TableBuilder::TableBuilder()
+    : juce::Thread("Pulsar table builder")
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+TableBuilder::~TableBuilder()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(1000);
+}
+
+void TableBuilder::request(const TableRecipe& recipe)
+{
+    {
+        const juce::ScopedLock sl(requestLock);
+        pendingRecipe = recipe;
+        hasPendingRecipe = true;
+        ++numRequested;
+    }
+
+    notify();
+}
+
+bool TableBuilder::waitUntilBuilt(int timeoutMilliseconds)
+{
+    auto endTime = juce::Time::getMillisecondCounter() + (juce::uint32)juce::jmax(0, timeoutMilliseconds);
+
+    while (numBuilt.load() < numRequested.load())
+    {
+        if (juce::Time::getMillisecondCounter() >= endTime)
+            return false;
+
+        juce::Thread::sleep(1);
+    }
+
+    return true;
+}
+
+/*
+* the hazard is checked against the current set again once it is stored. If the builder swapped sets
+* in between, it may not have seen the hazard, so the new set is taken instead. Only ever loops as often
+* as the builder publishes, a few times a second at most.
+*/
+const TableSet* TableBuilder::acquire()
+{
+    auto* set = current.load();
+
+    for (;;)
+    {
+        hazard.store(set);
+        auto* latest = current.load();
+
+        if (latest == set)
+            return set;
+
+        set = latest;
+    }
+}
+
+void TableBuilder::run()
+{
+    while (!threadShouldExit())
+    {
+        /* the timeout comes round to free a set the audio thread was still reading last time. */
+        wait(100);
+
+        TableRecipe recipe;
+        auto requestNumber = 0;
+        auto hasRecipe = false;
+
+        {
+            const juce::ScopedLock sl(requestLock);
+            std::swap(hasRecipe, hasPendingRecipe);
+            recipe = std::move(pendingRecipe);
+            pendingRecipe = {};
+            requestNumber = numRequested.load();
+        }
+
+        if (hasRecipe)
+        {
+            publish(build(recipe));
+            numBuilt = requestNumber;
+        }
+
+        reclaim();
+    }
+}
+
+/* frames are converted by the bank the first time they are used, so a frame used before costs nothing. */
+std::unique_ptr<TableSet> TableBuilder::build(const TableRecipe& recipe)
+{
+    auto set = std::make_unique<TableSet>();
+    set->bank = recipe.bank;
+
+    if (recipe.bank != nullptr && recipe.carrierFrame >= 0)
+    {
+        set->carrier = &recipe.bank->getCarrier(recipe.carrierFrame);
+    }
+    else if (!recipe.harmonics.empty())
+    {
+        set->ownedCarrier = std::make_unique<WavetableMipmap>(recipe.harmonics, recipe.tableSize);
+        set->carrier = set->ownedCarrier.get();
+    }
+
+    if (recipe.bank != nullptr && recipe.windowFrame >= 0)
+        set->window = &recipe.bank->getWindow(recipe.windowFrame);
+
+    return set;
+}
+
+void TableBuilder::publish(std::unique_ptr<TableSet> newSet)
+{
+    newSet->generation = ++numPublished;
+    current.store(newSet.get());
+
+    if (published != nullptr)
+        retired.push_back(std::move(published));
+
+    published = std::move(newSet);
+}
+
+/* after the store in publish, a set that is not the hazard can no longer be picked up by acquire. */
+void TableBuilder::reclaim()
+{
+    auto* inUse = hazard.load();
+
+    retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                 [inUse](const std::unique_ptr<TableSet>& set) { return set.get() != inUse; }),
+                  retired.end());
+}
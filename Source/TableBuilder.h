@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavetableMipmap.h"
+#include "WavetableBank.h"
+#include "MappedWavetableBank.h"
+
+/* what the voices' tables should be built from, the message thread's side of TableBuilder. */
+struct TableRecipe
+{
+    /* the carrier's harmonics, harmonics[h - 1] is the sine amplitude of harmonic h. Empty keeps the voices' sine. */
+    std::vector<float> harmonics;
+    int tableSize = WavetableBank::defaultTableSize;
+
+    /* frames of a wavetable file, -1 for none. A carrier frame is used instead of the harmonics. */
+    std::shared_ptr<MappedWavetableBank> bank;
+    int carrierFrame = -1, windowFrame = -1;
+};
+
+/* one complete set of tables for the voices, never changed once it has been published. */
+struct TableSet
+{
+    /* null keeps the voices' sine carrier or windowShape window. */
+    const WavetableMipmap* carrier = nullptr;
+    const juce::AudioSampleBuffer* window = nullptr;
+
+    /* counts up from 1 with every set published, a new set can reuse a freed set's addresses. */
+    juce::uint32 generation = 0;
+
+    /* whatever the pointers above point into, freed with the set. */
+    std::unique_ptr<WavetableMipmap> ownedCarrier;
+    std::shared_ptr<MappedWavetableBank> bank;
+};
+
+/*
+* Builds the voices' tables on a thread of its own, so editing a shape never stalls the audio thread.
+* The message thread hands over a recipe, the builder works it through the ffts and band limiting,
+* then swaps the finished set in with one atomic store. Voices carry on with the old set until then.
+*
+* A set that has been replaced is only freed once the audio thread is no longer reading it.
+* The audio thread names the set it is reading in a hazard pointer, acquire never blocks or allocates,
+* the builder frees every retired set except that one and tries the rest again on its next pass.
+*/
+class TableBuilder : private juce::Thread
+{
+public:
+    TableBuilder();
+    ~TableBuilder() override;
+
+    /* message thread. A recipe not started yet is replaced by the next, only the latest is built. */
+    void request(const TableRecipe& recipe);
+
+    /* message thread, for offline renders. true once everything requested has been published. */
+    bool waitUntilBuilt(int timeoutMilliseconds);
+
+    /*
+    * audio thread, the latest set, or null before the first is built. It stays valid until the next call,
+    * so call it once per block and read only that set for the whole block.
+    */
+    const TableSet* acquire();
+private:
+    void run() override;
+    std::unique_ptr<TableSet> build(const TableRecipe& recipe);
+    void publish(std::unique_ptr<TableSet> newSet);
+    void reclaim();
+
+    /* only between the message thread and the builder, never taken by the audio thread. */
+    juce::CriticalSection requestLock;
+    TableRecipe pendingRecipe;
+    bool hasPendingRecipe = false;
+    std::atomic<int> numRequested { 0 }, numBuilt { 0 };
+
+    /* the published set and the one the audio thread is reading, they differ until its next acquire. */
+    std::atomic<TableSet*> current { nullptr };
+    std::atomic<TableSet*> hazard { nullptr };
+
+    /* the builder thread's, the owner of the current set and of the replaced ones waiting to be freed. */
+    std::unique_ptr<TableSet> published;
+    std::vector<std::unique_ptr<TableSet>> retired;
+    juce::uint32 numPublished = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TableBuilder)
+};
@@ -0,0 +1,209 @@
+#include "VoiceRenderPool.h"
+#include "RealtimeCheck.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    /* tells the core this is a spin wait, so it does not flood the pipeline while the worker finishes. */
+    inline void pauseCpu()
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (JUCE_CLANG || JUCE_GCC)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+}
+
+//==============================================================================
+class VoiceRenderPool::Worker : public juce::Thread
+{
+public:
+    Worker(VoiceRenderPool& ownerPool, int index)
+        : juce::Thread("Pulsar voice renderer " + juce::String(index)),
+          pool(ownerPool)
+    {
+    }
+
+    ~Worker() override
+    {
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        juce::ScopedNoDenormals noDenormals;
+        auto seen = getGeneration(pool.claims.load());
+        int idle = 0;
+
+        while (!threadShouldExit())
+        {
+            auto current = getGeneration(pool.claims.load(std::memory_order_acquire));
+
+            if (current == seen)
+            {
+                backOff(++idle);
+                continue;
+            }
+
+            seen = current;
+            idle = 0;
+
+            const RealtimeCheck::ScopedSection realtime;
+            pool.renderClaimedVoices();
+        }
+    }
+private:
+    /*
+    * spins while blocks are arriving back to back, then yields, then sleeps a millisecond at a time.
+    * A sleeping worker misses the start of a block, the audio thread renders its voices instead.
+    */
+    static void backOff(int idle)
+    {
+        if (idle < maxSpins)
+            return;
+
+        if (idle < maxSpins + maxYields)
+            std::this_thread::yield();
+        else
+            juce::Thread::sleep(1);
+    }
+
+    static constexpr int maxSpins = 4096;
+    static constexpr int maxYields = 256;
+
+    VoiceRenderPool& pool;
+};
+
+//==============================================================================
+VoiceRenderPool::VoiceRenderPool()
+{
+}
+
+VoiceRenderPool::~VoiceRenderPool()
+{
+    workers.clear();
+}
+
+void VoiceRenderPool::setNumWorkers(int numWorkers)
+{
+    workers.clear();
+
+    auto numCpus = juce::SystemStats::getNumCpus();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        /* the audio thread renders too, so workers start at 1 and so do their cores. */
+        auto* worker = workers.add(new Worker(*this, i + 1));
+        worker->setAffinityMask((juce::uint32)1 << ((i + 1) % juce::jmin(numCpus, 32)));
+        worker->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+int VoiceRenderPool::getNumWorkers() const
+{
+    return workers.size();
+}
+
+void VoiceRenderPool::prepare(int numChannels, int maxBlockSize, int maxVoices)
+{
+    scratchBuffers.clear();
+    numScratchChannels = numChannels;
+
+    jassert(maxVoices <= maxClaimVoices);
+
+    for (int i = 0; i < maxVoices; ++i)
+        scratchBuffers.add(new juce::AudioSampleBuffer(numChannels, maxBlockSize));
+}
+
+bool VoiceRenderPool::render(juce::SynthesiserVoice* const* voices, int numVoices,
+                             juce::AudioSampleBuffer& output, int startSample, int numSamples)
+{
+    if (workers.isEmpty() || numVoices > scratchBuffers.size()
+        || numSamples > scratchBuffers[0]->getNumSamples()
+        || output.getNumChannels() != numScratchChannels)
+        return false;
+
+    jobVoices     = voices;
+    jobNumSamples = numSamples;
+    finishedVoices.store(0, std::memory_order_relaxed);
+
+    /* the job is published by this store, a claim that reads it also sees the fields above. */
+    ++jobGeneration;
+    claims.store(makeClaims(jobGeneration, numVoices, 0), std::memory_order_release);
+
+    renderClaimedVoices();
+    waitForWorkers(numVoices);
+
+    /* sum in voice order, the result is the same whichever thread rendered each voice. */
+    for (int v = 0; v < numVoices; ++v)
+    {
+        for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            output.addFrom(channel, startSample, *scratchBuffers[v], channel, 0, numSamples);
+    }
+
+    return true;
+}
+
+/*
+* a claim is a compare exchange on the whole word, generation and voice count included. A worker that read
+* the word during an earlier block fails the exchange and reads the new job, it can never claim a voice
+* of this block against the voice count of the last one.
+*/
+void VoiceRenderPool::renderClaimedVoices()
+{
+    auto current = claims.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        auto v = getNextVoice(current);
+
+        if (v >= getNumVoices(current))
+            return;
+
+        if (!claims.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            continue;
+
+        current = current + 1;
+
+        auto& scratch = *scratchBuffers[v];
+        scratch.clear(0, jobNumSamples);
+        jobVoices[v]->renderNextBlock(scratch, 0, jobNumSamples);
+        finishedVoices.fetch_add(1, std::memory_order_release);
+    }
+}
+
+/*
+* every voice is claimed by now, so this only waits for voices a worker is part way through, a voice at most.
+* A worker the scheduler took off the core can hold it up longer, past the deadline that counts as a late wait
+* and the wait carries on with a pause hint. The voice cannot be taken over, it is half rendered.
+*/
+void VoiceRenderPool::waitForWorkers(int numVoices)
+{
+    auto deadline = juce::Time::getHighResolutionTicks()
+                      + juce::Time::secondsToHighResolutionTicks(maxWaitMicroseconds * 1.0e-6);
+    auto late = false;
+
+    while (finishedVoices.load(std::memory_order_acquire) < numVoices)
+    {
+        if (late)
+        {
+            pauseCpu();
+        }
+        else if (juce::Time::getHighResolutionTicks() > deadline)
+        {
+            late = true;
+            ++numLateWaits;
+        }
+    }
+}
+
+int VoiceRenderPool::getAndResetNumLateWaits()
+{
+    auto numLate = numLateWaits;
+    numLateWaits = 0;
+    return numLate;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+* Renders synthesiser voices on a pool of worker threads.
+* Each voice is claimed from a shared counter by whichever thread gets to it first, the audio thread
+* included, and rendered into the voice's own scratch buffer. The counter carries the block's generation,
+* so a claim made for one block can never land in the next. The buffers are summed in voice order,
+* so the output does not depend on which thread rendered what.
+*
+* Nothing in render locks, allocates or signals. The workers are never woken, they watch for the next
+* block, spinning at first and then backing off to short sleeps. The audio thread does not wait for them
+* either, it renders every voice no worker has claimed yet, and then only waits for the ones in progress. A wait
+* past maxWaitMicroseconds is counted, so a starved worker shows up in the telemetry.
+*/
+class VoiceRenderPool
+{
+public:
+    VoiceRenderPool();
+    ~VoiceRenderPool();
+
+    /*
+    * starts numWorkers threads, each pinned to its own core. These and prepare are for a pool that is not
+    * rendering yet, PulsarSynthesiser builds a new pool and swaps it for the one in use.
+    */
+    void setNumWorkers(int numWorkers);
+    int getNumWorkers() const;
+
+    /* allocates one scratch buffer per voice. */
+    void prepare(int numChannels, int maxBlockSize, int maxVoices);
+
+    /*
+    * adds the voices into output. returns false without rendering if there are no workers, or the block
+    * does not fit the prepared scratch buffers. The channel count must match, voices pan by it.
+    */
+    bool render(juce::SynthesiserVoice* const* voices, int numVoices,
+                juce::AudioSampleBuffer& output, int startSample, int numSamples);
+
+    /* audio thread, the renders since the last call that waited on a worker past maxWaitMicroseconds. */
+    int getAndResetNumLateWaits();
+
+    static constexpr double maxWaitMicroseconds = 200.0;
+private:
+    class Worker;
+
+    /* claims and renders voices until none are left. */
+    void renderClaimedVoices();
+    void waitForWorkers(int numVoices);
+
+    /* the claim word, the block's generation, its voice count and the next voice to claim. */
+    static constexpr int maxClaimVoices = 0xffff;
+
+    static juce::uint64 makeClaims(juce::uint32 generation, int numVoices, int nextVoice)
+    {
+        return ((juce::uint64)generation << 32) | ((juce::uint64)numVoices << 16) | (juce::uint64)nextVoice;
+    }
+
+    static juce::uint32 getGeneration(juce::uint64 claimWord) { return (juce::uint32)(claimWord >> 32); }
+    static int getNumVoices(juce::uint64 claimWord)            { return (int)((claimWord >> 16) & maxClaimVoices); }
+    static int getNextVoice(juce::uint64 claimWord)            { return (int)(claimWord & maxClaimVoices); }
+
+    juce::OwnedArray<Worker> workers;
+    juce::OwnedArray<juce::AudioSampleBuffer> scratchBuffers;
+    int numScratchChannels = 0;
+
+    /* the block being rendered, written by the audio thread before the claim word opens it. */
+    juce::SynthesiserVoice* const* jobVoices = nullptr;
+    int jobNumSamples = 0;
+    juce::uint32 jobGeneration = 0;
+
+    /* between blocks every voice of the last block is claimed, so there is nothing to claim until the next. */
+    std::atomic<juce::uint64> claims { 0 };
+    std::atomic<int> finishedVoices { 0 };
+    int numLateWaits = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoiceRenderPool)
+};
@@ -11,20 +11,194 @@
 #include "Wavetable.h"
 
 Wavetable::Wavetable(const juce::AudioSampleBuffer& tableToUse)
-    : wavetable(tableToUse),
-    tableSize(wavetable.getNumSamples() - 1)
+    : wavetable(tableToUse.getReadPointer(0)),
+    tableSize(tableToUse.getNumSamples() - 1)
 {
     /* this should be here but It created error's when testing on apple machines */
-     jassert(wavetable.getNumChannels() == 1);
+     jassert(tableToUse.getNumChannels() == 1);
+     setFixedPointLayout();
+}
+
+Wavetable::Wavetable(const WavetableMipmap& mipmapToUse)
+    : mipmap(&mipmapToUse),
+    wavetable(mipmapToUse.getLevel(0).getReadPointer(0)),
+    tableSize(mipmapToUse.getTableSize())
+{
+    setFixedPointLayout();
+}
+
+Wavetable::Wavetable(const float* tableToUse, int tableSizeToUse)
+    : wavetable(tableToUse),
+    tableSize(tableSizeToUse)
+{
+    setFixedPointLayout();
+}
+
+void Wavetable::setFixedPointLayout()
+{
+    fractionBits = 0;
+
+    if (tableSize < 2 || !juce::isPowerOfTwo(tableSize))
+        return;
+
+    auto indexBits = 0;
+
+    while ((1 << indexBits) < tableSize)
+        ++indexBits;
+
+    fractionBits = 32 - indexBits;
+    fractionMask = (juce::uint32)((1ull << fractionBits) - 1);
+    fractionScale = 1.0f / (float)(1ull << fractionBits);
 }
 
 float Wavetable::getNextSample(float index)
+{
+    /* a block of one, so both paths share the same reads. */
+    auto currentSample = 0.0f;
+    processBlock(&index, &currentSample, 1);
+    return currentSample;
+}
+
+void Wavetable::processBlock(const float* indices, float* output, int numSamples)
+{
+    switch (interpolation)
+    {
+        case Interpolation::none:     processBlockWith<Interpolation::none>     (indices, output, numSamples); break;
+        case Interpolation::linear:   processBlockWith<Interpolation::linear>   (indices, output, numSamples); break;
+        case Interpolation::hermite:  processBlockWith<Interpolation::hermite>  (indices, output, numSamples); break;
+        case Interpolation::lagrange: processBlockWith<Interpolation::lagrange> (indices, output, numSamples); break;
+    }
+}
+
+void Wavetable::processBlock(const juce::uint32* phases, float* output, int numSamples)
+{
+    /* fixed point reads need a power of two table. */
+    jassert(fractionBits > 0);
+
+    switch (interpolation)
+    {
+        case Interpolation::none:     processBlockWith<Interpolation::none>     (phases, output, numSamples); break;
+        case Interpolation::linear:   processBlockWith<Interpolation::linear>   (phases, output, numSamples); break;
+        case Interpolation::hermite:  processBlockWith<Interpolation::hermite>  (phases, output, numSamples); break;
+        case Interpolation::lagrange: processBlockWith<Interpolation::lagrange> (phases, output, numSamples); break;
+    }
+}
+
+template <Wavetable::Interpolation mode>
+void Wavetable::processBlockWith(const float* indices, float* output, int numSamples)
+{
+    /* the crossfade is decided once per block, so is the loop. */
+    if (nextLevel != nullptr)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto currentSample = readSample<mode>(wavetable);
+            output[i] = currentSample + crossfade * (readSample<mode>(nextLevel) - currentSample);
+            setIndex(indices[i]);
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        output[i] = readSample<mode>(wavetable);
+        setIndex(indices[i]);
+    }
+}
+
+template <Wavetable::Interpolation mode>
+void Wavetable::processBlockWith(const juce::uint32* phases, float* output, int numSamples)
+{
+    if (nextLevel != nullptr)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto currentSample = readSample<mode>(wavetable, phases[i]);
+            output[i] = currentSample + crossfade * (readSample<mode>(nextLevel, phases[i]) - currentSample);
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        output[i] = readSample<mode>(wavetable, phases[i]);
+}
+
+void Wavetable::setPhaseIncrement(float phaseIncrement)
+{
+    if (mipmap == nullptr)
+        return;
+
+    auto position = mipmap->getLevelPosition(phaseIncrement);
+    auto level = (int)position;
+
+    wavetable = mipmap->getLevel(level).getReadPointer(0);
+    crossfade = position - (float)level;
+
+    nextLevel = (crossfadeLevels && crossfade > 0.0f) ? mipmap->getLevel(level + 1).getReadPointer(0)
+                                                      : nullptr;
+}
+
+void Wavetable::setCrossfade(bool shouldCrossfade)
+{
+    crossfadeLevels = shouldCrossfade;
+
+    if (!crossfadeLevels)
+        nextLevel = nullptr;
+}
+
+void Wavetable::setTable(const float* tableToUse, int tableSizeToUse)
+{
+    mipmap = nullptr;
+    nextLevel = nullptr;
+    wavetable = tableToUse;
+
+    if (tableSizeToUse != tableSize)
+    {
+        tableSize = tableSizeToUse;
+        setFixedPointLayout();
+    }
+}
+
+void Wavetable::setMipmap(const WavetableMipmap& mipmapToUse)
+{
+    mipmap = &mipmapToUse;
+    nextLevel = nullptr;
+    wavetable = mipmapToUse.getLevel(0).getReadPointer(0);
+
+    if (mipmapToUse.getTableSize() != tableSize)
+    {
+        tableSize = mipmapToUse.getTableSize();
+        setFixedPointLayout();
+    }
+}
+
+int Wavetable::getTableSize() const
+{
+    return tableSize;
+}
+
+void Wavetable::setInterpolation(Interpolation newInterpolation)
+{
+    interpolation = newInterpolation;
+}
+
+Wavetable::Interpolation Wavetable::getInterpolation() const
+{
+    return interpolation;
+}
+
+void Wavetable::setPeriodic(bool isPeriodic)
+{
+    periodic = isPeriodic;
+}
+
+template <Wavetable::Interpolation mode>
+float Wavetable::interpolate(const float* table, unsigned int index0, float frac) const
 {
     /*
     * interpolate between samples.
-    * wrap next index around the size of the table.
-    * retreive fractional value by subtracting from the truncated current index.
-    * get AudioSampleBuffer pointer and the two sample values.
     * interpolation is the value at the truncated index + the diference between that value and the next multiplied by the fracional value.
     * why is it not just the diference between both values?
     * say value0 is 0.5 and value1 is 0.25 (0.25 - 0.5 = -0.25).
@@ -32,24 +206,85 @@ float Wavetable::getNextSample(float index)
     * tableDelta is 1.277 so if the current index is 0 + 1.277 index0 is 1. and frac is 1.277 - 1. = 0.277
     * so 0.5 + (0.277 * -0.25) is (-0.69)
     */
+    if (mode == Interpolation::none)
+        return table[index0];
 
-    auto index0 = (unsigned int)_index;
-    auto index1 = index0 + 1; // no wrapping, compensated for in create wavetable.
+    auto value0 = table[index0];
+    auto value1 = table[index0 + 1]; // no wrapping, compensated for in create wavetable.
+
+    if (mode == Interpolation::linear)
+        return value0 + frac * (value1 - value0);
+
+    /*
+    * the cubics also need the samples either side, these wrap around a periodic table.
+    * the guard of a window is its first sample, so past the last sample a window holds it instead.
+    */
+    auto lastIndex = (unsigned int)tableSize - 1;
+    auto index2 = index0 + 2;
+    float valueMinus1, value2;
+
+    if (periodic)
+    {
+        valueMinus1 = table[(index0 == 0) ? lastIndex : index0 - 1];
+        value2 = table[(index2 > (unsigned int)tableSize) ? index2 - (unsigned int)tableSize : index2];
+    }
+    else
+    {
+        if (index0 == lastIndex)
+            value1 = value0;
+
+        valueMinus1 = table[(index0 == 0) ? 0 : index0 - 1];
+        value2 = table[juce::jmin(index2, lastIndex)];
+    }
+
+    if (mode == Interpolation::hermite)
+    {
+        /* 4 point, 3rd order hermite (catmull-rom). */
+        auto c1 = 0.5f * (value1 - valueMinus1);
+        auto c2 = valueMinus1 - 2.5f * value0 + 2.0f * value1 - 0.5f * value2;
+        auto c3 = 0.5f * (value2 - valueMinus1) + 1.5f * (value0 - value1);
+
+        return ((c3 * frac + c2) * frac + c1) * frac + value0;
+    }
+
+    /* 4 point lagrange through the samples at -1, 0, 1 and 2. */
+    auto dMinus1 = frac + 1.0f;
+    auto d1 = frac - 1.0f;
+    auto d2 = frac - 2.0f;
 
+    return -frac * d1 * d2 * (1.0f / 6.0f) * valueMinus1
+         + dMinus1 * d1 * d2 * 0.5f * value0
+         - dMinus1 * frac * d2 * 0.5f * value1
+         + dMinus1 * frac * d1 * (1.0f / 6.0f) * value2;
+}
+
+template <Wavetable::Interpolation mode>
+float Wavetable::readSample(const float* table) const
+{
+    /* retreive fractional value by subtracting from the truncated current index. */
+    auto index0 = (unsigned int)_index;
     auto frac = _index - (float)index0;
 
-    auto* table = wavetable.getReadPointer(0);
-    auto value0 = table[index0];
-    auto value1 = table[index1];
+    return interpolate<mode>(table, index0, frac);
+}
 
-    auto currentSample = value0 + frac * (value1 - value0);
+template <Wavetable::Interpolation mode>
+float Wavetable::readSample(const float* table, juce::uint32 phase) const
+{
+    /* the same interpolation, no fmod needed since the phase has already wrapped. */
+    auto index0 = phase >> fractionBits;
+    auto frac = (float)(phase & fractionMask) * fractionScale;
+
+    return interpolate<mode>(table, index0, frac);
+}
 
+void Wavetable::setIndex(float index)
+{
     /*
     * in order to perform fm with a unipolar signal I need the index to wrap.
     * This may not be the ideal solution test further.
     */
-    _index = abs(fmod(index * (float)tableSize, (float)tableSize));
-    return currentSample;
+    _index = std::abs(std::fmod(index * (float)tableSize, (float)tableSize));
 }
 
 Wavetable::~Wavetable()
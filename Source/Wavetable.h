@@ -10,16 +10,95 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "WavetableMipmap.h"
 
-/* this class takes as input a phasor and reads a wavetable with simple linear interpolation. */
+/*
+* this class takes as input a phasor and reads a wavetable, with linear interpolation unless told otherwise.
+* when built from a WavetableMipmap the level is chosen with setPhaseIncrement, call it once per block.
+*/
 class Wavetable
 {
 public:
+    /*
+    * none reads the nearest sample below, linear is the original two point interpolation,
+    * hermite and lagrange are four point cubics, better at low frequencies and for FM at a higher cost.
+    */
+    enum class Interpolation
+    {
+        none,
+        linear,
+        hermite,
+        lagrange
+    };
+
     Wavetable(const juce::AudioSampleBuffer& tableToUse);
+    Wavetable(const WavetableMipmap& mipmapToUse);
+
+    /* reads static data such as WindowTables directly, tableToUse holds tableSizeToUse + 1 samples. */
+    Wavetable(const float* tableToUse, int tableSizeToUse);
     ~Wavetable();
     float getNextSample(float index);
+
+    /* runs getNextSample over a block of indices, output[i] is what getNextSample(indices[i]) would return. */
+    void processBlock(const float* indices, float* output, int numSamples);
+
+    /*
+    * fixed point version, a phase of 2^32 is one cycle so phases wrap on their own.
+    * the top bits are the table index and the rest the fraction, the table size must be a power of two.
+    * unlike the float version the sample at phases[i] is returned straight away.
+    */
+    void processBlock(const juce::uint32* phases, float* output, int numSamples);
+
+    /* picks the mipmap level for the fastest phase increment (cycles per sample) expected in the next block. */
+    void setPhaseIncrement(float phaseIncrement);
+    void setCrossfade(bool shouldCrossfade);
+
+    /* switches to another single table (not a mipmap), nothing is copied so the table must outlive this. */
+    void setTable(const float* tableToUse, int tableSizeToUse);
+
+    /* switches to another mipmap, which must outlive this. call setPhaseIncrement again before reading. */
+    void setMipmap(const WavetableMipmap& mipmapToUse);
+    int getTableSize() const;
+
+    /* picked once per block, each mode has its own loop so nothing is branched on per sample. */
+    void setInterpolation(Interpolation newInterpolation);
+    Interpolation getInterpolation() const;
+
+    /*
+    * a periodic table (the default) wraps around for the cubics' outer samples. windows are read once from
+    * start to end, so they hold their first and last samples instead of reaching across to the other end.
+    */
+    void setPeriodic(bool isPeriodic);
 private:
-    const juce::AudioSampleBuffer& wavetable;
+    template <Interpolation mode>
+    void processBlockWith(const float* indices, float* output, int numSamples);
+
+    template <Interpolation mode>
+    void processBlockWith(const juce::uint32* phases, float* output, int numSamples);
+
+    template <Interpolation mode>
+    float interpolate(const float* table, unsigned int index0, float frac) const;
+
+    template <Interpolation mode>
+    float readSample(const float* table) const;
+
+    template <Interpolation mode>
+    float readSample(const float* table, juce::uint32 phase) const;
+    void setIndex(float index);
+    void setFixedPointLayout();
+
+    const WavetableMipmap* mipmap = nullptr;
+    const float* wavetable = nullptr;
+    const float* nextLevel = nullptr;
+    float crossfade = 0.0f;
+    bool crossfadeLevels = false;
+    Interpolation interpolation = Interpolation::linear;
+    bool periodic = true;
     float _index = 0.0f;
     int tableSize;
+
+    /* fixed point phase layout, index = phase >> fractionBits. */
+    int fractionBits = 0;
+    juce::uint32 fractionMask = 0;
+    float fractionScale = 0.0f;
 };
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "WavetableBank.h"
+
+WavetableBank::WavetableBank()
+{
+}
+
+WavetableBank::~WavetableBank()
+{
+}
+
+const juce::AudioSampleBuffer& WavetableBank::getTable(Shape shape, int tableSize)
+{
+    /* voices are created on the message thread, the lock only guards against two asking at once. */
+    const juce::ScopedLock sl(lock);
+
+    /* waveforms other than sine only exist band limited, hand back the level with every harmonic. */
+    if (shape != Shape::sine && shape != Shape::hann)
+        return getMipmap(shape, tableSize).getLevel(0);
+
+    auto& table = tables[{ shape, tableSize }];
+
+    if (table == nullptr)
+    {
+        table = std::make_unique<juce::AudioSampleBuffer>();
+        fillTable(shape, *table, tableSize);
+    }
+
+    return *table;
+}
+
+const WavetableMipmap& WavetableBank::getMipmap(Shape shape, int tableSize)
+{
+    jassert(shape != Shape::hann);
+
+    const juce::ScopedLock sl(lock);
+
+    auto& mipmap = mipmaps[{ shape, tableSize }];
+
+    if (mipmap == nullptr)
+        mipmap = std::make_unique<WavetableMipmap>(getHarmonics(shape, tableSize / 2), tableSize);
+
+    return *mipmap;
+}
+
+std::vector<float> WavetableBank::getHarmonics(Shape shape, int numHarmonics)
+{
+    std::vector<float> harmonics((size_t)numHarmonics, 0.0f);
+    auto pi = juce::MathConstants<float>::pi;
+
+    for (int h = 1; h <= numHarmonics; ++h)
+    {
+        auto& amplitude = harmonics[(size_t)h - 1];
+        auto isOdd = (h % 2) == 1;
+
+        switch (shape)
+        {
+            case Shape::sine:     amplitude = (h == 1) ? 1.0f : 0.0f; break;
+            case Shape::saw:      amplitude = (isOdd ? 2.0f : -2.0f) / (pi * (float)h); break;
+            case Shape::square:   amplitude = isOdd ? 4.0f / (pi * (float)h) : 0.0f; break;
+            case Shape::triangle: amplitude = isOdd ? (((h / 2) % 2 == 0) ? 8.0f : -8.0f) / (pi * pi * (float)(h * h)) : 0.0f; break;
+            case Shape::hann:     break;
+        }
+    }
+
+    return harmonics;
+}
+
+/*
+* tables are one sample longer than tableSize, the last sample is a copy of the first
+* so the interpolation in Wavetable never has to wrap.
+*/
+void WavetableBank::fillTable(Shape shape, juce::AudioSampleBuffer& table, int tableSize)
+{
+    table.setSize(1, tableSize + 1);
+    table.clear();
+
+    auto* samples = table.getWritePointer(0);
+
+    auto angleDelta = juce::MathConstants<double>::twoPi / (double)(tableSize - 1);
+    auto currentAngle = 0.0;
+
+    for (int i = 0; i < tableSize; ++i)
+    {
+        auto sample = (shape == Shape::hann) ? 0.5 - 0.5 * std::cos(currentAngle)
+                                             : std::sin(currentAngle);
+        samples[i] = (float)sample;
+        currentAngle += angleDelta;
+    }
+
+    samples[tableSize] = samples[0];
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavetableMipmap.h"
+
+/*
+* One read only set of tables for the whole process.
+* Hold it with a juce::SharedResourcePointer<WavetableBank>, the bank is created by the first
+* pointer and deleted with the last, so every voice shares the same tables.
+*/
+class WavetableBank
+{
+public:
+    enum class Shape
+    {
+        sine,
+        hann,
+        saw,
+        square,
+        triangle
+    };
+
+    WavetableBank();
+    ~WavetableBank();
+
+    /* returns the table for a shape and size, it is built the first time it is asked for. */
+    const juce::AudioSampleBuffer& getTable(Shape shape, int tableSize = defaultTableSize);
+
+    /* band limited version of a waveform, built from its harmonics. not available for windows. */
+    const WavetableMipmap& getMipmap(Shape shape, int tableSize = defaultTableSize);
+
+    /* the fourier series of a waveform, harmonics[h - 1] is the sine amplitude of harmonic h. */
+    static std::vector<float> getHarmonics(Shape shape, int numHarmonics);
+
+    static constexpr int defaultTableSize = 1 << 9;
+private:
+    static void fillTable(Shape shape, juce::AudioSampleBuffer& table, int tableSize);
+
+    juce::CriticalSection lock;
+    std::map<std::pair<Shape, int>, std::unique_ptr<juce::AudioSampleBuffer>> tables;
+    std::map<std::pair<Shape, int>, std::unique_ptr<WavetableMipmap>> mipmaps;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WavetableBank)
+};
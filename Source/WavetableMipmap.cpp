@@ -0,0 +1,159 @@
+#include "WavetableMipmap.h"
+
+WavetableMipmap::WavetableMipmap(const std::vector<float>& harmonics, int size)
+    : tableSize(size)
+{
+    jassert(juce::isPowerOfTwo(tableSize));
+
+    /* a sine of amplitude a at bin h is -a/2 i there and a/2 i at its mirror, times the size for the inverse. */
+    Spectrum spectrum((size_t)tableSize);
+    auto numHarmonics = juce::jmin((int)harmonics.size(), tableSize / 2 - 1);
+
+    for (int h = 1; h <= numHarmonics; ++h)
+    {
+        auto amplitude = 0.5 * (double)tableSize * (double)harmonics[(size_t)h - 1];
+        spectrum[(size_t)h] = { 0.0, -amplitude };
+        spectrum[(size_t)(tableSize - h)] = { 0.0, amplitude };
+    }
+
+    addLevels(spectrum, true);
+}
+
+WavetableMipmap::WavetableMipmap(const float* cycle, int size)
+    : tableSize(size)
+{
+    jassert(juce::isPowerOfTwo(tableSize));
+
+    Spectrum spectrum((size_t)tableSize);
+
+    for (int i = 0; i < tableSize; ++i)
+        spectrum[(size_t)i] = cycle[i];
+
+    transform(spectrum, false);
+    addLevels(spectrum, false);
+}
+
+WavetableMipmap::~WavetableMipmap()
+{
+}
+
+/*
+* table size / 2 harmonics fit in level 0, halve that for every level until none are left.
+* The nyquist bin is left out as it cannot be told apart from its alias.
+*/
+void WavetableMipmap::addLevels(const Spectrum& spectrum, bool normalise)
+{
+    Spectrum bins;
+    auto gain = 1.0f;
+
+    for (auto numHarmonics = tableSize / 2; ; numHarmonics /= 2)
+    {
+        bins.assign((size_t)tableSize, {});
+
+        for (int h = 1; h <= juce::jmin(numHarmonics, tableSize / 2 - 1); ++h)
+        {
+            bins[(size_t)h] = spectrum[(size_t)h];
+            bins[(size_t)(tableSize - h)] = spectrum[(size_t)(tableSize - h)];
+        }
+
+        transform(bins, true);
+
+        auto* level = levels.add(new juce::AudioSampleBuffer(1, tableSize + 1));
+        auto* samples = level->getWritePointer(0);
+
+        for (int i = 0; i < tableSize; ++i)
+            samples[i] = (float)(bins[(size_t)i].real() / (double)tableSize);
+
+        /* every level is scaled by the peak of level 0 so the levels match in loudness. */
+        if (normalise && levels.size() == 1)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax(samples, tableSize);
+            auto peak = juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd()));
+            gain = (peak > 0.0f) ? 1.0f / peak : 1.0f;
+        }
+
+        juce::FloatVectorOperations::multiply(samples, gain, tableSize);
+
+        /* guard sample, so the interpolation never has to wrap. */
+        samples[tableSize] = samples[0];
+
+        if (numHarmonics == 0)
+            break;
+    }
+}
+
+void WavetableMipmap::transform(Spectrum& bins, bool inverse)
+{
+    auto size = (int)bins.size();
+
+    /* bit reversed order first, then the butterflies. */
+    for (int i = 1, j = 0; i < size; ++i)
+    {
+        auto bit = size >> 1;
+
+        for (; (j & bit) != 0; bit >>= 1)
+            j ^= bit;
+
+        j ^= bit;
+
+        if (i < j)
+            std::swap(bins[(size_t)i], bins[(size_t)j]);
+    }
+
+    for (int length = 2; length <= size; length <<= 1)
+    {
+        auto angle = (inverse ? 1.0 : -1.0) * juce::MathConstants<double>::twoPi / (double)length;
+        std::complex<double> step(std::cos(angle), std::sin(angle));
+
+        for (int start = 0; start < size; start += length)
+        {
+            std::complex<double> twiddle(1.0, 0.0);
+
+            for (int k = 0; k < length / 2; ++k)
+            {
+                auto& even = bins[(size_t)(start + k)];
+                auto& odd = bins[(size_t)(start + k + length / 2)];
+                auto product = odd * twiddle;
+
+                odd = even - product;
+                even += product;
+                twiddle *= step;
+            }
+        }
+    }
+}
+
+int WavetableMipmap::getNumLevels() const
+{
+    return levels.size();
+}
+
+int WavetableMipmap::getTableSize() const
+{
+    return tableSize;
+}
+
+const juce::AudioSampleBuffer& WavetableMipmap::getLevel(int level) const
+{
+    return *levels[juce::jlimit(0, levels.size() - 1, level)];
+}
+
+float WavetableMipmap::getLevelPosition(float phaseIncrement) const
+{
+    /*
+    * level k holds (tableSize / 2) >> k harmonics, it does not alias while
+    * ((tableSize / 2) >> k) * increment <= 0.5, that is k >= log2(tableSize * increment).
+    */
+    auto octave = std::log2(std::abs(phaseIncrement) * (float)tableSize);
+
+    if (!(octave > 0.0f))
+        return 0.0f;
+
+    auto level = std::ceil(octave);
+    auto lastLevel = (float)(levels.size() - 1);
+
+    if (level >= lastLevel)
+        return lastLevel;
+
+    return level + (octave - (level - 1.0f));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+
+/*
+* A set of band limited tables, one per octave, built from a list of harmonic amplitudes.
+* Level 0 holds every harmonic the table can represent, each level after that holds half as many,
+* the last level is silent for frequencies above nyquist.
+*/
+class WavetableMipmap
+{
+public:
+    /*
+    * harmonics[0] is the amplitude of the fundamental, harmonics[1] the second harmonic and so on.
+    * Every level is an inverse fft of the harmonics it keeps, scaled so level 0 peaks at 1.
+    */
+    WavetableMipmap(const std::vector<float>& harmonics, int tableSize);
+
+    /*
+    * from one cycle of tableSize samples, a frame of a wavetable file for example.
+    * the cycle is taken apart with an fft and each level rebuilt from its harmonics, phases and all.
+    * The levels keep the cycle's own level, only its dc offset is removed.
+    */
+    WavetableMipmap(const float* cycle, int tableSize);
+    ~WavetableMipmap();
+
+    int getNumLevels() const;
+    int getTableSize() const;
+    const juce::AudioSampleBuffer& getLevel(int level) const;
+
+    /*
+    * where a phase increment (cycles per sample) falls between the levels.
+    * the integer part is the first level that does not alias, the fractional part is how far
+    * to crossfade towards the next one.
+    */
+    float getLevelPosition(float phaseIncrement) const;
+private:
+    using Spectrum = std::vector<std::complex<double>>;
+
+    /* in place radix 2 fft, the inverse is not scaled. */
+    static void transform(Spectrum& bins, bool inverse);
+
+    /* one level per octave from the spectrum of a cycle, dc and nyquist left out. */
+    void addLevels(const Spectrum& spectrum, bool normalise);
+
+    juce::OwnedArray<juce::AudioSampleBuffer> levels;
+    int tableSize;
+};
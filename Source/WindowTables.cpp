@@ -0,0 +1,160 @@
+#include "WindowTables.h"
+
+namespace
+{
+    using Table = std::array<float, WindowTables::tableSize + 1>;
+    using Shape = WindowTables::Shape;
+
+    constexpr double pi = 3.14159265358979323846;
+
+    /*
+    * std::sin and std::exp are not constexpr, these are accurate enough for a float table.
+    * sine reduces the argument to [-pi, pi] and sums a Taylor series.
+    */
+    constexpr double sine(double x)
+    {
+        auto turns = x / (2.0 * pi);
+        auto wholeTurns = (double)(long long)(turns + (turns >= 0.0 ? 0.5 : -0.5));
+        x -= wholeTurns * 2.0 * pi;
+
+        auto term = x, sum = x;
+
+        for (int n = 1; n < 14; ++n)
+        {
+            term *= -x * x / (double)((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    constexpr double cosine(double x)
+    {
+        return sine(x + 0.5 * pi);
+    }
+
+    /* e^x = (e^(x / 2^k))^(2^k), the series converges quickly once the argument is small. */
+    constexpr double exponential(double x)
+    {
+        int halvings = 0;
+
+        while (x > 0.5 || x < -0.5)
+        {
+            x *= 0.5;
+            ++halvings;
+        }
+
+        auto term = 1.0, sum = 1.0;
+
+        for (int n = 1; n < 20; ++n)
+        {
+            term *= x / (double)n;
+            sum += term;
+        }
+
+        while (halvings-- > 0)
+            sum *= sum;
+
+        return sum;
+    }
+
+    /* x runs from 0 at the start of the window to 1 at the end. */
+    constexpr double getWindowValue(Shape shape, double x)
+    {
+        switch (shape)
+        {
+            case Shape::hann:
+                return 0.5 - 0.5 * cosine(2.0 * pi * x);
+
+            case Shape::gaussian:
+            {
+                constexpr double deviation = 0.15;
+                auto distance = (x - 0.5) / deviation;
+                return exponential(-0.5 * distance * distance);
+            }
+
+            case Shape::tukey:
+            {
+                /* half the window is flat, a quarter is a cosine taper at each end. */
+                constexpr double taper = 0.5;
+
+                if (x < 0.5 * taper)
+                    return 0.5 - 0.5 * cosine(2.0 * pi * x / taper);
+
+                if (x > 1.0 - 0.5 * taper)
+                    return 0.5 - 0.5 * cosine(2.0 * pi * (1.0 - x) / taper);
+
+                return 1.0;
+            }
+
+            case Shape::expodec:
+            case Shape::rexpodec:
+            {
+                /* an exponential decay scaled to reach exactly 0, rexpodec is the same reversed. */
+                constexpr double rate = 6.0;
+                auto position = (shape == Shape::expodec) ? x : 1.0 - x;
+                auto end = exponential(-rate);
+                return (exponential(-rate * position) - end) / (1.0 - end);
+            }
+
+            case Shape::trapezoid:
+            {
+                constexpr double ramp = 0.25;
+                auto attack = x / ramp, release = (1.0 - x) / ramp;
+                auto value = (attack < release) ? attack : release;
+                return (value < 1.0) ? value : 1.0;
+            }
+
+            case Shape::sinc:
+            {
+                /* four zero crossings either side of the peak. */
+                constexpr double zeroCrossings = 4.0;
+                auto u = pi * (x - 0.5) * 2.0 * zeroCrossings;
+                return (u == 0.0) ? 1.0 : sine(u) / u;
+            }
+        }
+
+        return 0.0;
+    }
+
+    constexpr Table makeTable(Shape shape)
+    {
+        Table table {};
+
+        for (int i = 0; i < WindowTables::tableSize; ++i)
+            table[(size_t)i] = (float)getWindowValue(shape, (double)i / (double)(WindowTables::tableSize - 1));
+
+        /*
+        * Pulsar holds the window phase on the last sample once the pulse has finished, it has to be silent.
+        * Only rexpodec (cut off at its peak) and the gaussian (truncated tails) are not already 0 there.
+        */
+        table[WindowTables::tableSize - 1] = 0.0f;
+        table[WindowTables::tableSize] = table[0];
+        return table;
+    }
+
+    /* one constant per shape, so each is a separate (and smaller) compile time evaluation. */
+    constexpr Table hannTable      = makeTable(Shape::hann);
+    constexpr Table gaussianTable  = makeTable(Shape::gaussian);
+    constexpr Table tukeyTable     = makeTable(Shape::tukey);
+    constexpr Table expodecTable   = makeTable(Shape::expodec);
+    constexpr Table rexpodecTable  = makeTable(Shape::rexpodec);
+    constexpr Table trapezoidTable = makeTable(Shape::trapezoid);
+    constexpr Table sincTable      = makeTable(Shape::sinc);
+}
+
+const float* WindowTables::getTable(Shape shape)
+{
+    switch (shape)
+    {
+        case Shape::hann:      return hannTable.data();
+        case Shape::gaussian:  return gaussianTable.data();
+        case Shape::tukey:     return tukeyTable.data();
+        case Shape::expodec:   return expodecTable.data();
+        case Shape::rexpodec:  return rexpodecTable.data();
+        case Shape::trapezoid: return trapezoidTable.data();
+        case Shape::sinc:      return sincTable.data();
+    }
+
+    return hannTable.data();
+}
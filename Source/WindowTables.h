@@ -0,0 +1,30 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+* Pulsaret window shapes (see Roads, Microsound 4.3), generated at compile time.
+* The tables are constant data in the binary, so creating a voice or switching shape does no table work.
+* Each table is tableSize + 1 samples long, the window runs from sample 0 to sample tableSize - 1
+* and the last sample is a guard copy of the first, the same layout as every other wavetable here.
+* Sample tableSize - 1, the end of the window, is always 0.
+*/
+class WindowTables
+{
+public:
+    enum class Shape
+    {
+        hann,
+        gaussian,
+        tukey,
+        expodec,
+        rexpodec,
+        trapezoid,
+        sinc
+    };
+
+    static constexpr int numShapes = 7;
+    static constexpr int tableSize = 512;
+
+    static const float* getTable(Shape shape);
+};